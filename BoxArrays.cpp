@@ -0,0 +1,164 @@
+#include "BoxArrays.h"
+#include <algorithm>
+#include <limits>
+#include "Simd.h"
+
+namespace {
+
+// Runs scalar on the unaligned head and the tail, and four lanes at a time on aligned blocks
+// in between. Planes are 64-byte aligned, so an index divisible by four is a 16-byte boundary.
+void addToPlane(float* data, size_t first, size_t last, float value) {
+    size_t i = first;
+
+#ifdef SHDK_SSE2
+    for (; i < last && (i & 3); ++i) data[i] += value;
+
+    __m128 add = _mm_set1_ps(value);
+    for (; i + 4 <= last; i += 4) {
+        _mm_store_ps(data + i, _mm_add_ps(_mm_load_ps(data + i), add));
+    }
+#endif
+
+    for (; i < last; ++i) data[i] += value;
+}
+
+// min(centre - half) and max(centre + half), or plain min and max when half is null
+void extentOfPlanes(const float* centre, const float* half, size_t count, float& outMin, float& outMax) {
+    float low = std::numeric_limits<float>::max();
+    float high = std::numeric_limits<float>::lowest();
+    size_t i = 0;
+
+#ifdef SHDK_SSE2
+    if (count >= 4) {
+        __m128 lowV = _mm_set1_ps(low);
+        __m128 highV = _mm_set1_ps(high);
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 c = _mm_load_ps(centre + i);
+            __m128 h = half ? _mm_load_ps(half + i) : _mm_setzero_ps();
+            lowV = _mm_min_ps(lowV, _mm_sub_ps(c, h));
+            highV = _mm_max_ps(highV, _mm_add_ps(c, h));
+        }
+
+        alignas(16) float lows[4];
+        alignas(16) float highs[4];
+        _mm_store_ps(lows, lowV);
+        _mm_store_ps(highs, highV);
+
+        low = std::min({lows[0], lows[1], lows[2], lows[3]});
+        high = std::max({highs[0], highs[1], highs[2], highs[3]});
+    }
+#endif
+
+    for (; i < count; ++i) {
+        float h = half ? half[i] : 0.0f;
+        low = std::min(low, centre[i] - h);
+        high = std::max(high, centre[i] + h);
+    }
+
+    outMin = low;
+    outMax = high;
+}
+
+}
+
+void BoxArrays::reserve(size_t count) {
+    for (FloatArray& plane : m_planes) plane.reserve(count);
+    m_templates.reserve(count);
+}
+
+void BoxArrays::clear() {
+    for (FloatArray& plane : m_planes) plane.clear();
+    m_templates.clear();
+    m_size = 0;
+}
+
+void BoxArrays::append(const QVector3D& position, const QVector3D& size, const std::array<GLfloat, 3>& colour,
+                       InternedString templateType) {
+    const float values[PlaneCount] = {
+        position.x(), position.y(), position.z(),
+        size.x(), size.y(), size.z(),
+        colour[0], colour[1], colour[2],
+        0.0f
+    };
+
+    for (int p = 0; p < PlaneCount; ++p) m_planes[p].push_back(values[p]);
+    m_templates.push_back(templateType);
+    m_size++;
+}
+
+void BoxArrays::append(const BoxArrays& other) {
+    for (int p = 0; p < PlaneCount; ++p) {
+        if (p == Selected) m_planes[p].resize(m_size + other.m_size, 0.0f);
+        else m_planes[p].insert(m_planes[p].end(), other.m_planes[p].begin(), other.m_planes[p].end());
+    }
+    m_templates.insert(m_templates.end(), other.m_templates.begin(), other.m_templates.end());
+    m_size += other.m_size;
+}
+
+void BoxArrays::resize(size_t count) {
+    for (FloatArray& plane : m_planes) plane.resize(count, 0.0f);
+    m_templates.resize(count);
+    m_size = count;
+}
+
+void BoxArrays::swapRemove(size_t index) {
+    for (FloatArray& plane : m_planes) {
+        plane[index] = plane.back();
+        plane.pop_back();
+    }
+    m_templates[index] = m_templates.back();
+    m_templates.pop_back();
+    m_size--;
+}
+
+Rect3D BoxArrays::box(size_t index) const {
+    Rect3D rect(position(index), halfSize(index));
+    rect.setColour({m_planes[Red][index], m_planes[Green][index], m_planes[Blue][index]});
+    return rect;
+}
+
+void BoxArrays::setBox(size_t index, const Rect3D& rect) {
+    std::array<GLfloat, 3> colour = rect.getColour();
+
+    m_planes[X][index] = rect.x();
+    m_planes[Y][index] = rect.y();
+    m_planes[Z][index] = rect.z();
+    m_planes[Width][index] = rect.width();
+    m_planes[Height][index] = rect.height();
+    m_planes[Depth][index] = rect.depth();
+    m_planes[Red][index] = colour[0];
+    m_planes[Green][index] = colour[1];
+    m_planes[Blue][index] = colour[2];
+}
+
+void BoxArrays::translate(size_t first, size_t last, const QVector3D& delta) {
+    if (delta.x() != 0.0f) addToPlane(m_planes[X].data(), first, last, delta.x());
+    if (delta.y() != 0.0f) addToPlane(m_planes[Y].data(), first, last, delta.y());
+    if (delta.z() != 0.0f) addToPlane(m_planes[Z].data(), first, last, delta.z());
+}
+
+void BoxArrays::translate(size_t index, const QVector3D& delta) {
+    m_planes[X][index] += delta.x();
+    m_planes[Y][index] += delta.y();
+    m_planes[Z][index] += delta.z();
+}
+
+std::pair<float, float> BoxArrays::range(Plane plane) const {
+    if (m_size == 0) return {0.0f, 0.0f};
+
+    float low, high;
+    extentOfPlanes(m_planes[plane].data(), nullptr, m_size, low, high);
+    return {low, high};
+}
+
+BoxArrays::Bounds BoxArrays::bounds() const {
+    if (m_size == 0) return Bounds();
+
+    float low[3], high[3];
+    extentOfPlanes(m_planes[X].data(), m_planes[Width].data(), m_size, low[0], high[0]);
+    extentOfPlanes(m_planes[Y].data(), m_planes[Height].data(), m_size, low[1], high[1]);
+    extentOfPlanes(m_planes[Z].data(), m_planes[Depth].data(), m_size, low[2], high[2]);
+
+    return {QVector3D(low[0], low[1], low[2]), QVector3D(high[0], high[1], high[2])};
+}
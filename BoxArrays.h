@@ -0,0 +1,109 @@
+#ifndef BOXARRAYS_H
+#define BOXARRAYS_H
+
+#include <QVector3D>
+#include <array>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "CopyCounter.h"
+#include "InternedString.h"
+#include "Rect3D.h"
+
+// Hands out memory aligned for SIMD loads, a cache line by default
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t count) {
+        void* memory = ::operator new(count * sizeof(T), std::align_val_t(Alignment));
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T* pointer, size_t) {
+        ::operator delete(pointer, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+// Boxes as one aligned float array per field. Bulk moves and bound queries run as SIMD loops
+// over whole planes, and each plane uploads to the GPU as-is as one instance attribute.
+// Template ids ride alongside in their own array, they never go to the GPU.
+class BoxArrays {
+public:
+    using FloatArray = std::vector<float, AlignedAllocator<float>>;
+
+    // Sizes are half extents, as in Rect3D. Selected is 0 or 1 so it can go to the GPU unchanged.
+    enum Plane { X, Y, Z, Width, Height, Depth, Red, Green, Blue, Selected, PlaneCount };
+
+    struct Bounds {
+        QVector3D min;
+        QVector3D max;
+    };
+
+    size_t size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    void reserve(size_t count);
+    void clear();
+
+    void append(const QVector3D& position, const QVector3D& size, const std::array<GLfloat, 3>& colour,
+                InternedString templateType = InternedString());
+    void append(const Rect3D& rect) { append(rect.position(), rect.size(), rect.getColour()); }
+
+    // Every box of other in one copy per plane, unselected
+    void append(const BoxArrays& other);
+
+    // Grows or shrinks to count boxes. New ones are zero, unselected and have no template.
+    void resize(size_t count);
+
+    // Moves the last box into index and drops the last slot
+    void swapRemove(size_t index);
+
+    Rect3D box(size_t index) const;
+    void setBox(size_t index, const Rect3D& rect);
+
+    QVector3D position(size_t index) const { return QVector3D(m_planes[X][index], m_planes[Y][index], m_planes[Z][index]); }
+    QVector3D halfSize(size_t index) const { return QVector3D(m_planes[Width][index], m_planes[Height][index], m_planes[Depth][index]); }
+
+    InternedString templateType(size_t index) const { return m_templates[index]; }
+    void setTemplateType(size_t index, InternedString templateType) { m_templates[index] = templateType; }
+
+    float value(size_t index, Plane plane) const { return m_planes[plane][index]; }
+    void setValue(size_t index, Plane plane, float value) { m_planes[plane][index] = value; }
+
+    bool isSelected(size_t index) const { return m_planes[Selected][index] != 0.0f; }
+    void setSelected(size_t index, bool selected) { m_planes[Selected][index] = selected ? 1.0f : 0.0f; }
+
+    const float* plane(Plane plane) const { return m_planes[plane].data(); }
+    float* plane(Plane plane) { return m_planes[plane].data(); }
+
+    // Moves boxes [first, last) by delta
+    void translate(size_t first, size_t last, const QVector3D& delta);
+    void translate(size_t index, const QVector3D& delta);
+
+    // Smallest and largest value of one plane, {0, 0} when empty
+    std::pair<float, float> range(Plane plane) const;
+
+    // Box extents along each axis, centre minus and plus the half size
+    Bounds bounds() const;
+
+private:
+    std::array<FloatArray, PlaneCount> m_planes;
+    std::vector<InternedString> m_templates;
+    size_t m_size = 0;
+    CopyCounter<BoxArrays> m_copies;  // Loads must move their arrays into the store, the self-test checks
+};
+
+#endif // BOXARRAYS_H
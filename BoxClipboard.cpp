@@ -0,0 +1,191 @@
+#include "BoxClipboard.h"
+#include <QDataStream>
+#include <QHash>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QtEndian>
+#include <charconv>
+#include <vector>
+#include "SegmentLoader.h"
+
+namespace {
+
+constexpr quint32 kMagic = 0x58424853;  // "SHBX"
+constexpr quint16 kVersion = 1;
+
+// Position, size and colour. Selected stays behind, pasted boxes come in unselected.
+constexpr int kPlaneCount = BoxArrays::Blue + 1;
+
+// Shortest text that reads back as the same float
+QString formatFloat(float value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return QString::fromLatin1(buffer, int(result.ptr - buffer));
+}
+
+QString formatVector(float x, float y, float z) {
+    return formatFloat(x) + ' ' + formatFloat(y) + ' ' + formatFloat(z);
+}
+
+bool parseVector(QStringView text, QVector3D& out) {
+    QList<QStringView> parts = text.split(' ', Qt::SkipEmptyParts);
+    if (parts.size() != 3) return false;
+
+    out = QVector3D(parts[0].toFloat(), parts[1].toFloat(), parts[2].toFloat());
+    return true;
+}
+
+}
+
+QByteArray BoxClipboard::encode(const BoxArrays& boxes) {
+    const quint32 count = static_cast<quint32>(boxes.size());
+
+    // Payload-local template indices, interned ids mean nothing in another process
+    QStringList names;
+    QHash<quint32, quint16> indexOfId;
+    std::vector<quint16> templates(count);
+
+    names << QString();
+    indexOfId.insert(0, 0);
+
+    for (quint32 i = 0; i < count; ++i) {
+        InternedString templateType = boxes.templateType(i);
+
+        auto it = indexOfId.constFind(templateType.id());
+        if (it == indexOfId.cend()) {
+            // A segment uses a handful of templates, past 65535 they go untemplated
+            if (names.size() > 0xFFFF) continue;
+
+            it = indexOfId.insert(templateType.id(), static_cast<quint16>(names.size()));
+            names << templateType.toString();
+        }
+        templates[i] = it.value();
+    }
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    out << kMagic << kVersion << count << names;
+
+    std::vector<float> plane(count);
+    for (int p = 0; p < kPlaneCount; ++p) {
+        qToLittleEndian<float>(boxes.plane(BoxArrays::Plane(p)), count, plane.data());
+        out.writeRawData(reinterpret_cast<const char*>(plane.data()), int(count * sizeof(float)));
+    }
+
+    qToLittleEndian<quint16>(templates.data(), count, templates.data());
+    out.writeRawData(reinterpret_cast<const char*>(templates.data()), int(count * sizeof(quint16)));
+
+    return data;
+}
+
+std::optional<BoxArrays> BoxClipboard::decode(const QByteArray& data) {
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_6_0);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 count = 0;
+    QStringList names;
+
+    in >> magic >> version >> count >> names;
+    if (in.status() != QDataStream::Ok || magic != kMagic || version != kVersion || names.isEmpty()) return std::nullopt;
+
+    // Check the size before allocating, the count comes from whoever filled the clipboard
+    qint64 expected = qint64(count) * (kPlaneCount * sizeof(float) + sizeof(quint16));
+    if (data.size() - in.device()->pos() != expected) return std::nullopt;
+
+    std::vector<InternedString> table;
+    table.reserve(names.size());
+    for (const QString& name : names) table.emplace_back(name);
+
+    BoxArrays boxes;
+    boxes.resize(count);
+
+    for (int p = 0; p < kPlaneCount; ++p) {
+        float* plane = boxes.plane(BoxArrays::Plane(p));
+        in.readRawData(reinterpret_cast<char*>(plane), int(count * sizeof(float)));
+        qFromLittleEndian<float>(plane, count, plane);
+    }
+
+    std::vector<quint16> templates(count);
+    in.readRawData(reinterpret_cast<char*>(templates.data()), int(count * sizeof(quint16)));
+    qFromLittleEndian<quint16>(templates.data(), count, templates.data());
+
+    for (quint32 i = 0; i < count; ++i) {
+        if (templates[i] >= table.size()) return std::nullopt;
+        boxes.setTemplateType(i, table[templates[i]]);
+    }
+
+    return boxes;
+}
+
+QString BoxClipboard::toXml(const BoxArrays& boxes) {
+    QString text;
+    QXmlStreamWriter xml(&text);
+    xml.setAutoFormatting(true);
+    xml.setAutoFormattingIndent(-1);  // Tabs, as in the game's segment files
+
+    xml.writeStartElement("segment");
+
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        QVector3D pos = boxes.position(i);
+        QVector3D size = boxes.halfSize(i);
+
+        xml.writeEmptyElement("box");
+        xml.writeAttribute("pos", formatVector(pos.x(), pos.y(), pos.z()));
+        xml.writeAttribute("size", formatVector(size.x(), size.y(), size.z()));
+
+        InternedString templateType = boxes.templateType(i);
+        if (!templateType.isEmpty()) xml.writeAttribute("template", templateType.toString());
+    }
+
+    xml.writeEndElement();
+    return text;
+}
+
+BoxArrays BoxClipboard::fromXml(const QString& text, const QString& rootDir) {
+    BoxArrays boxes;
+    QXmlStreamReader xml(text);
+
+    // Read for each paste, so the colours follow templates.xml like a load does
+    Loader::TemplateTable templates(rootDir);
+
+    // Read up to the first error, a fragment cut mid-element still gives the boxes before it
+    while (!xml.atEnd() && !xml.hasError()) {
+        xml.readNext();
+        if (!xml.isStartElement() || xml.name() != QLatin1String("box")) continue;
+
+        QVector3D pos;
+        QVector3D size;
+        if (!parseVector(xml.attributes().value("pos"), pos) || !parseVector(xml.attributes().value("size"), size)) continue;
+
+        InternedString templateType(xml.attributes().value("template"));
+        boxes.append(pos, size, templates.colour(templateType), templateType);
+    }
+
+    return boxes;
+}
+
+QMimeData* BoxClipboard::toMimeData(const BoxArrays& boxes) {
+    QMimeData* mime = new QMimeData;
+    mime->setData(kMimeType, encode(boxes));
+    mime->setText(toXml(boxes));
+    return mime;
+}
+
+BoxArrays BoxClipboard::fromMimeData(const QMimeData* mime, const QString& rootDir) {
+    if (!mime) return BoxArrays();
+
+    if (mime->hasFormat(kMimeType)) {
+        std::optional<BoxArrays> boxes = decode(mime->data(kMimeType));
+        if (boxes) return std::move(*boxes);
+    }
+
+    if (mime->hasText()) return fromXml(mime->text(), rootDir);
+
+    return BoxArrays();
+}
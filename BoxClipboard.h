@@ -0,0 +1,33 @@
+#ifndef BOXCLIPBOARD_H
+#define BOXCLIPBOARD_H
+
+#include <QByteArray>
+#include <QMimeData>
+#include <QString>
+#include <optional>
+#include "BoxArrays.h"
+
+// Boxes on the clipboard. The binary form is the box planes as-is plus a table of template names,
+// about 38 bytes a box, so pasting between editor windows is a few memcpys. Text editors get the
+// same boxes as segment XML, and XML pasted back in, a whole segment file included, reads as boxes.
+namespace BoxClipboard {
+    inline constexpr char kMimeType[] = "application/x-smashhitdevkit-boxes";
+
+    QByteArray encode(const BoxArrays& boxes);
+
+    // Empty if data isn't a payload from encode()
+    std::optional<BoxArrays> decode(const QByteArray& data);
+
+    QString toXml(const BoxArrays& boxes);
+
+    // Every <box> element in text, coloured from rootDir's templates
+    BoxArrays fromXml(const QString& text, const QString& rootDir);
+
+    // Both forms, for QClipboard::setMimeData() to take ownership of
+    QMimeData* toMimeData(const BoxArrays& boxes);
+
+    // The binary form when there is one, otherwise the text read as XML. Empty when neither has boxes.
+    BoxArrays fromMimeData(const QMimeData* mime, const QString& rootDir);
+}
+
+#endif // BOXCLIPBOARD_H
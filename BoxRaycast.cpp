@@ -0,0 +1,316 @@
+#include "BoxRaycast.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include "Simd.h"
+
+#if defined(SHDK_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(SHDK_X86)
+#include <cpuid.h>
+#endif
+
+namespace {
+
+struct Planes {
+    const float* centre[3];
+    const float* half[3];
+};
+
+// Directions under 1e-6 on an axis count as parallel to it, as the old per-box test did. The huge
+// reciprocal keeps the maths finite: a parallel slab then spans everything or nothing.
+struct Ray {
+    float origin[3];
+    float inverse[3];
+    float limit;
+};
+
+struct Candidate {
+    float distance;
+    int64_t index = -1;
+};
+
+void scalarKernel(const Planes& p, const Ray& ray, size_t first, size_t last, Candidate& best) {
+    for (size_t i = first; i < last; ++i) {
+        float tNear = 0.0f;
+        float tFar = ray.limit;
+
+        for (int a = 0; a < 3; ++a) {
+            float lo = (p.centre[a][i] - p.half[a][i] - ray.origin[a]) * ray.inverse[a];
+            float hi = (p.centre[a][i] + p.half[a][i] - ray.origin[a]) * ray.inverse[a];
+            tNear = std::max(tNear, std::min(lo, hi));
+            tFar = std::min(tFar, std::max(lo, hi));
+        }
+
+        if (tNear <= tFar && tNear < best.distance) {
+            best.distance = tNear;
+            best.index = static_cast<int64_t>(i);
+        }
+    }
+}
+
+// Folds the per-lane winners into best. Lanes hold ascending indices, so ties keep the lower one.
+void mergeLanes(const float* distances, const int32_t* indices, int lanes, Candidate& best) {
+    for (int k = 0; k < lanes; ++k) {
+        if (indices[k] < 0) continue;
+        if (distances[k] < best.distance || (distances[k] == best.distance && indices[k] < best.index)) {
+            best.distance = distances[k];
+            best.index = indices[k];
+        }
+    }
+}
+
+#ifdef SHDK_SSE2
+void sse2Kernel(const Planes& p, const Ray& ray, size_t first, size_t last, Candidate& best) {
+    size_t i = first;
+
+    if (last - first >= 4) {
+        __m128 origin[3], inverse[3];
+        for (int a = 0; a < 3; ++a) {
+            origin[a] = _mm_set1_ps(ray.origin[a]);
+            inverse[a] = _mm_set1_ps(ray.inverse[a]);
+        }
+        const __m128 limit = _mm_set1_ps(ray.limit);
+
+        __m128 bestT = _mm_set1_ps(best.distance);
+        __m128i bestI = _mm_set1_epi32(-1);
+        __m128i lane = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(i)), _mm_setr_epi32(0, 1, 2, 3));
+        const __m128i step = _mm_set1_epi32(4);
+
+        for (; i + 4 <= last; i += 4) {
+            __m128 tNear = _mm_setzero_ps();
+            __m128 tFar = limit;
+
+            for (int a = 0; a < 3; ++a) {
+                __m128 c = _mm_loadu_ps(p.centre[a] + i);
+                __m128 h = _mm_loadu_ps(p.half[a] + i);
+                __m128 lo = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(c, h), origin[a]), inverse[a]);
+                __m128 hi = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(c, h), origin[a]), inverse[a]);
+                tNear = _mm_max_ps(tNear, _mm_min_ps(lo, hi));
+                tFar = _mm_min_ps(tFar, _mm_max_ps(lo, hi));
+            }
+
+            __m128 hit = _mm_and_ps(_mm_cmple_ps(tNear, tFar), _mm_cmplt_ps(tNear, bestT));
+            __m128i hitI = _mm_castps_si128(hit);
+
+            bestT = _mm_or_ps(_mm_and_ps(hit, tNear), _mm_andnot_ps(hit, bestT));
+            bestI = _mm_or_si128(_mm_and_si128(hitI, lane), _mm_andnot_si128(hitI, bestI));
+            lane = _mm_add_epi32(lane, step);
+        }
+
+        alignas(16) float distances[4];
+        alignas(16) int32_t indices[4];
+        _mm_store_ps(distances, bestT);
+        _mm_store_si128(reinterpret_cast<__m128i*>(indices), bestI);
+        mergeLanes(distances, indices, 4, best);
+    }
+
+    scalarKernel(p, ray, i, last, best);
+}
+
+SHDK_TARGET("avx2")
+void avx2Kernel(const Planes& p, const Ray& ray, size_t first, size_t last, Candidate& best) {
+    size_t i = first;
+
+    if (last - first >= 8) {
+        __m256 origin[3], inverse[3];
+        for (int a = 0; a < 3; ++a) {
+            origin[a] = _mm256_set1_ps(ray.origin[a]);
+            inverse[a] = _mm256_set1_ps(ray.inverse[a]);
+        }
+        const __m256 limit = _mm256_set1_ps(ray.limit);
+
+        __m256 bestT = _mm256_set1_ps(best.distance);
+        __m256i bestI = _mm256_set1_epi32(-1);
+        __m256i lane = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        const __m256i step = _mm256_set1_epi32(8);
+
+        for (; i + 8 <= last; i += 8) {
+            __m256 tNear = _mm256_setzero_ps();
+            __m256 tFar = limit;
+
+            for (int a = 0; a < 3; ++a) {
+                __m256 c = _mm256_loadu_ps(p.centre[a] + i);
+                __m256 h = _mm256_loadu_ps(p.half[a] + i);
+                __m256 lo = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(c, h), origin[a]), inverse[a]);
+                __m256 hi = _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(c, h), origin[a]), inverse[a]);
+                tNear = _mm256_max_ps(tNear, _mm256_min_ps(lo, hi));
+                tFar = _mm256_min_ps(tFar, _mm256_max_ps(lo, hi));
+            }
+
+            __m256 hit = _mm256_and_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ), _mm256_cmp_ps(tNear, bestT, _CMP_LT_OQ));
+
+            bestT = _mm256_blendv_ps(bestT, tNear, hit);
+            bestI = _mm256_blendv_epi8(bestI, lane, _mm256_castps_si256(hit));
+            lane = _mm256_add_epi32(lane, step);
+        }
+
+        alignas(32) float distances[8];
+        alignas(32) int32_t indices[8];
+        _mm256_store_ps(distances, bestT);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(indices), bestI);
+        mergeLanes(distances, indices, 8, best);
+    }
+
+    sse2Kernel(p, ray, i, last, best);
+}
+
+SHDK_TARGET("avx512f")
+void avx512Kernel(const Planes& p, const Ray& ray, size_t first, size_t last, Candidate& best) {
+    size_t i = first;
+
+    if (last - first >= 16) {
+        __m512 origin[3], inverse[3];
+        for (int a = 0; a < 3; ++a) {
+            origin[a] = _mm512_set1_ps(ray.origin[a]);
+            inverse[a] = _mm512_set1_ps(ray.inverse[a]);
+        }
+        const __m512 limit = _mm512_set1_ps(ray.limit);
+
+        __m512 bestT = _mm512_set1_ps(best.distance);
+        __m512i bestI = _mm512_set1_epi32(-1);
+        __m512i lane = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(i)),
+                                        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        const __m512i step = _mm512_set1_epi32(16);
+
+        for (; i + 16 <= last; i += 16) {
+            __m512 tNear = _mm512_setzero_ps();
+            __m512 tFar = limit;
+
+            for (int a = 0; a < 3; ++a) {
+                __m512 c = _mm512_loadu_ps(p.centre[a] + i);
+                __m512 h = _mm512_loadu_ps(p.half[a] + i);
+                __m512 lo = _mm512_mul_ps(_mm512_sub_ps(_mm512_sub_ps(c, h), origin[a]), inverse[a]);
+                __m512 hi = _mm512_mul_ps(_mm512_sub_ps(_mm512_add_ps(c, h), origin[a]), inverse[a]);
+                tNear = _mm512_max_ps(tNear, _mm512_min_ps(lo, hi));
+                tFar = _mm512_min_ps(tFar, _mm512_max_ps(lo, hi));
+            }
+
+            __mmask16 hit = _mm512_cmp_ps_mask(tNear, tFar, _CMP_LE_OQ)
+                          & _mm512_cmp_ps_mask(tNear, bestT, _CMP_LT_OQ);
+
+            bestT = _mm512_mask_mov_ps(bestT, hit, tNear);
+            bestI = _mm512_mask_mov_epi32(bestI, hit, lane);
+            lane = _mm512_add_epi32(lane, step);
+        }
+
+        alignas(64) float distances[16];
+        alignas(64) int32_t indices[16];
+        _mm512_store_ps(distances, bestT);
+        _mm512_store_si512(indices, bestI);
+        mergeLanes(distances, indices, 16, best);
+    }
+
+    avx2Kernel(p, ray, i, last, best);
+}
+#endif
+
+#ifdef SHDK_X86
+void cpuid(int leaf, int subleaf, unsigned regs[4]) {
+#ifdef _MSC_VER
+    int values[4];
+    __cpuidex(values, leaf, subleaf);
+    for (int k = 0; k < 4; ++k) regs[k] = static_cast<unsigned>(values[k]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Which register states the OS saves on a context switch, read from XCR0
+unsigned long long enabledStates() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+}
+#endif
+
+BoxRaycast::Isa detectIsa() {
+#ifdef SHDK_SSE2
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    const unsigned maxLeaf = regs[0];
+
+    cpuid(1, 0, regs);
+    const bool osxsave = regs[2] & (1u << 27);
+    const bool avx = regs[2] & (1u << 28);
+    if (maxLeaf < 7 || !osxsave || !avx) return BoxRaycast::Isa::SSE2;
+
+    const unsigned long long states = enabledStates();
+    const bool ymmSaved = (states & 0x6) == 0x6;
+    const bool zmmSaved = (states & 0xE6) == 0xE6;
+
+    cpuid(7, 0, regs);
+    const bool avx2 = regs[1] & (1u << 5);
+    const bool avx512f = regs[1] & (1u << 16);
+
+    if (avx512f && zmmSaved) return BoxRaycast::Isa::AVX512;
+    if (avx2 && ymmSaved) return BoxRaycast::Isa::AVX2;
+    return BoxRaycast::Isa::SSE2;
+#else
+    return BoxRaycast::Isa::Scalar;
+#endif
+}
+
+using Kernel = void (*)(const Planes&, const Ray&, size_t, size_t, Candidate&);
+
+Kernel kernelFor(BoxRaycast::Isa isa) {
+    switch (isa) {
+#ifdef SHDK_SSE2
+    case BoxRaycast::Isa::AVX512: return avx512Kernel;
+    case BoxRaycast::Isa::AVX2:   return avx2Kernel;
+    case BoxRaycast::Isa::SSE2:   return sse2Kernel;
+#endif
+    default:                      return scalarKernel;
+    }
+}
+
+}
+
+BoxRaycast::Isa BoxRaycast::activeIsa() {
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+const char* BoxRaycast::isaName(Isa isa) {
+    switch (isa) {
+    case Isa::SSE2:   return "SSE2";
+    case Isa::AVX2:   return "AVX2";
+    case Isa::AVX512: return "AVX-512";
+    default:          return "Scalar";
+    }
+}
+
+std::optional<BoxRaycast::Hit> BoxRaycast::nearest(const BoxArrays& boxes, const QVector3D& origin, const QVector3D& direction,
+                                                   size_t first, size_t last, float maxDistance) {
+    last = std::min(last, boxes.size());
+    if (first >= last || !(maxDistance >= 0.0f)) return std::nullopt;
+
+    Planes planes = {
+        {boxes.plane(BoxArrays::X), boxes.plane(BoxArrays::Y), boxes.plane(BoxArrays::Z)},
+        {boxes.plane(BoxArrays::Width), boxes.plane(BoxArrays::Height), boxes.plane(BoxArrays::Depth)}
+    };
+
+    Ray ray;
+    ray.limit = maxDistance;
+    for (int a = 0; a < 3; ++a) {
+        float d = direction[a];
+        ray.origin[a] = origin[a];
+        ray.inverse[a] = std::abs(d) < 1e-6f ? std::copysign(1e30f, d) : 1.0f / d;
+    }
+
+    Candidate best;
+    best.distance = maxDistance;
+
+    // Lanes carry 32-bit indices
+    static const Kernel kernel = kernelFor(activeIsa());
+    if (last <= static_cast<size_t>(INT_MAX)) kernel(planes, ray, first, last, best);
+    else scalarKernel(planes, ray, first, last, best);
+
+    if (best.index < 0) return std::nullopt;
+    return Hit{static_cast<size_t>(best.index), best.distance};
+}
@@ -0,0 +1,36 @@
+#ifndef BOXRAYCAST_H
+#define BOXRAYCAST_H
+
+#include <QVector3D>
+#include <limits>
+#include <optional>
+#include "BoxArrays.h"
+
+// Ray against axis-aligned boxes, straight off the BoxArrays planes. The slab test runs on 4, 8 or 16
+// boxes per step with SSE2, AVX2 or AVX-512, whichever the CPU has, and scalar anywhere else.
+namespace BoxRaycast {
+    enum class Isa { Scalar, SSE2, AVX2, AVX512 };
+
+    struct Hit {
+        size_t index;
+        float distance;
+    };
+
+    // Widest kernel this CPU and OS can run, checked once
+    Isa activeIsa();
+    const char* isaName(Isa isa);
+
+    // Nearest box in [first, last) the ray enters within maxDistance. Distance is in units of
+    // direction, so world units for a normalised direction, and 0 when the origin is inside the box.
+    // Equal distances go to the lower index.
+    std::optional<Hit> nearest(const BoxArrays& boxes, const QVector3D& origin, const QVector3D& direction,
+                               size_t first, size_t last,
+                               float maxDistance = std::numeric_limits<float>::infinity());
+
+    inline std::optional<Hit> nearest(const BoxArrays& boxes, const QVector3D& origin, const QVector3D& direction,
+                                      float maxDistance = std::numeric_limits<float>::infinity()) {
+        return nearest(boxes, origin, direction, 0, boxes.size(), maxDistance);
+    }
+}
+
+#endif // BOXRAYCAST_H
@@ -0,0 +1,95 @@
+#include "CameraPath.h"
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+
+float gameViewRunSpeed(const BoxArrays& boxes) {
+    if (boxes.isEmpty()) return 0.0f;
+
+    auto [minZ, maxZ] = boxes.range(BoxArrays::Z);
+
+    float zDistance = std::abs(maxZ - minZ);
+    return zDistance / (30.0f * 240.0f);
+}
+
+CameraPath CameraPath::gameRun(const BoxArrays& boxes, int frames, float fov) {
+    CameraPath path;
+    if (frames <= 0) return path;
+
+    // The game view eye sits at -gameViewPosition, and levels are laid out towards -Z
+    float furthest = boxes.isEmpty() ? 0.0f : std::max(0.0f, -boxes.bounds().min.z());
+
+    float step = frames > 1 ? furthest / (frames - 1) : 0.0f;
+
+    // Same state F8 resets the game view to, then advanced exactly like the W key does
+    RenderCamera camera;
+    camera.gameView = true;
+    camera.gameViewPosition = 0.0f;
+    camera.fov = fov;
+
+    for (int i = 0; i < frames; ++i) {
+        path.append(camera);
+        camera.advanceGameView(step);
+    }
+
+    return path;
+}
+
+bool CameraPath::load(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "Could not open camera path" << path;
+        return false;
+    }
+
+    m_frames.clear();
+
+    QTextStream in(&file);
+    int lineNumber = 0;
+
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        lineNumber++;
+
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        QStringList parts = line.split(' ', Qt::SkipEmptyParts);
+        if (parts.size() != 8) {
+            qWarning() << "Bad camera path line" << lineNumber << "in" << path;
+            return false;
+        }
+
+        RenderCamera camera;
+        camera.gameView = parts[0].toInt() != 0;
+        camera.gameViewPosition = parts[1].toFloat();
+        camera.position = QVector3D(parts[2].toFloat(), parts[3].toFloat(), parts[4].toFloat());
+        camera.yaw = parts[5].toFloat();
+        camera.pitch = parts[6].toFloat();
+        camera.fov = parts[7].toFloat();
+
+        m_frames.push_back(camera);
+    }
+
+    return true;
+}
+
+bool CameraPath::save(const QString& path) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Could not write camera path" << path;
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "# gameView gameViewPosition x y z yaw pitch fov\n";
+
+    for (const RenderCamera& camera : m_frames) {
+        out << (camera.gameView ? 1 : 0) << ' '
+            << camera.gameViewPosition << ' '
+            << camera.position.x() << ' ' << camera.position.y() << ' ' << camera.position.z() << ' '
+            << camera.yaw << ' ' << camera.pitch << ' ' << camera.fov << '\n';
+    }
+
+    return true;
+}
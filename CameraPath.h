@@ -0,0 +1,35 @@
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#include <QString>
+#include <vector>
+#include "BoxArrays.h"
+#include "SegmentRenderer.h"
+
+// Speed that crosses the whole scene in 30 seconds at 240 fps, what F7 sets in the 3D view
+float gameViewRunSpeed(const BoxArrays& boxes);
+
+// One camera per frame, either recorded in the 3D view (F10) or generated for the benchmark.
+// Saved as text, one frame per line: gameView gameViewPosition x y z yaw pitch fov
+class CameraPath {
+public:
+    CameraPath() = default;
+
+    // Holds W in game view from the start of the scene to its furthest box, in a fixed number of steps
+    static CameraPath gameRun(const BoxArrays& boxes, int frames, float fov);
+
+    bool load(const QString& path);
+    bool save(const QString& path) const;
+
+    void append(const RenderCamera& camera) { m_frames.push_back(camera); }
+    void clear() { m_frames.clear(); }
+
+    const RenderCamera& at(size_t frame) const { return m_frames[frame]; }
+    size_t size() const { return m_frames.size(); }
+    bool isEmpty() const { return m_frames.empty(); }
+
+private:
+    std::vector<RenderCamera> m_frames;
+};
+
+#endif // CAMERAPATH_H
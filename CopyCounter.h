@@ -0,0 +1,28 @@
+#ifndef COPYCOUNTER_H
+#define COPYCOUNTER_H
+
+#include <QtGlobal>
+
+// Member that counts copies of the type holding it, per Tag. Moves don't count, so a pipeline
+// that only moves its data leaves copies() at zero. Not thread safe, loads run on one thread.
+template <typename Tag>
+class CopyCounter {
+public:
+    CopyCounter() = default;
+    CopyCounter(const CopyCounter&) { ++s_copies; }
+    CopyCounter(CopyCounter&&) noexcept = default;
+
+    CopyCounter& operator=(const CopyCounter&) {
+        ++s_copies;
+        return *this;
+    }
+    CopyCounter& operator=(CopyCounter&&) noexcept = default;
+
+    static quint64 copies() { return s_copies; }
+    static void reset() { s_copies = 0; }
+
+private:
+    static inline quint64 s_copies = 0;
+};
+
+#endif // COPYCOUNTER_H
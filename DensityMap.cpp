@@ -0,0 +1,94 @@
+#include "DensityMap.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+QRgb DensityMap::heatColour(float t) {
+    // Blue for the odd box through green and yellow to red for the busiest bins
+    static const QColor stops[] = {QColor(0, 60, 255), QColor(0, 220, 120), QColor(255, 230, 0), QColor(255, 40, 0)};
+    const int last = 3;
+
+    float scaled = std::clamp(t, 0.0f, 1.0f) * last;
+    int i = std::min(static_cast<int>(scaled), last - 1);
+    float f = scaled - i;
+
+    const QColor& a = stops[i];
+    const QColor& b = stops[i + 1];
+
+    int alpha = 90 + static_cast<int>(165 * t);
+    return qPremultiply(qRgba(a.red() + (b.red() - a.red()) * f,
+                              a.green() + (b.green() - a.green()) * f,
+                              a.blue() + (b.blue() - a.blue()) * f,
+                              alpha));
+}
+
+void DensityMap::build(const SpatialIndex2D& index) {
+    m_image = QImage();
+    m_counts.clear();
+    if (index.size() == 0) return;
+
+    QRectF area = index.bounds(0);
+    for (size_t id = 1; id < index.size(); ++id) area |= index.bounds(static_cast<int>(id));
+
+    // Square bins, so the heatmap isn't stretched along the long axis of a level
+    m_binSize = std::max({area.width(), area.height(), qreal(1.0)}) / kMaxBins;
+    m_columns = std::max(1, static_cast<int>(std::ceil(area.width() / m_binSize)));
+    m_rows = std::max(1, static_cast<int>(std::ceil(area.height() / m_binSize)));
+
+    m_area = QRectF(area.topLeft(), QSizeF(m_columns * m_binSize, m_rows * m_binSize));
+    m_counts.assign(static_cast<size_t>(m_columns) * m_rows, 0);
+
+    for (size_t id = 0; id < index.size(); ++id) ++*binAt(index.bounds(static_cast<int>(id)).center());
+
+    m_image = QImage(m_columns, m_rows, QImage::Format_ARGB32_Premultiplied);
+    refresh();
+}
+
+quint32* DensityMap::binAt(const QPointF& centre) {
+    int cx = std::clamp(static_cast<int>((centre.x() - m_area.left()) / m_binSize), 0, m_columns - 1);
+    int cy = std::clamp(static_cast<int>((centre.y() - m_area.top()) / m_binSize), 0, m_rows - 1);
+    return &m_counts[static_cast<size_t>(cy) * m_columns + cx];
+}
+
+void DensityMap::remove(const QPointF& centre) {
+    if (m_counts.empty()) return;
+
+    quint32* count = binAt(centre);
+    if (*count) --*count;
+}
+
+bool DensityMap::add(const QPointF& centre) {
+    if (m_counts.empty() || !m_area.contains(centre)) return false;
+
+    ++*binAt(centre);
+    return true;
+}
+
+void DensityMap::refresh() {
+    if (m_image.isNull()) return;
+
+    quint32 maxCount = *std::max_element(m_counts.begin(), m_counts.end());
+
+    m_image.fill(Qt::transparent);
+    if (maxCount == 0) return;
+
+    // Log scale, a handful of huge clusters would otherwise wash out everything else
+    float scale = 1.0f / std::log1p(static_cast<float>(maxCount));
+
+    for (int y = 0; y < m_rows; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(m_image.scanLine(y));
+        for (int x = 0; x < m_columns; ++x) {
+            quint32 count = m_counts[static_cast<size_t>(y) * m_columns + x];
+            if (count) line[x] = heatColour(std::log1p(static_cast<float>(count)) * scale);
+        }
+    }
+}
+
+void DensityMap::draw(QPainter& painter) const {
+    if (m_image.isNull()) return;
+
+    painter.save();
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+    painter.drawImage(m_area, m_image);
+    painter.restore();
+}
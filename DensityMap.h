@@ -0,0 +1,43 @@
+#ifndef DENSITYMAP_H
+#define DENSITYMAP_H
+
+#include <QImage>
+#include <QPainter>
+#include <QRectF>
+#include <vector>
+#include "SpatialIndex2D.h"
+
+// Box centres binned into a coarse grid over one 2D projection and baked into a heatmap image.
+// Built once per load and patched per edit, drawing it is a single drawImage whatever the box count.
+class DensityMap {
+public:
+    void build(const SpatialIndex2D& index);
+    void draw(QPainter& painter) const;
+
+    // Moves one centre between bins. False if it landed outside the built area, which needs a build().
+    void remove(const QPointF& centre);
+    bool add(const QPointF& centre);
+
+    // Recolours the image after remove() and add(), costs the bin count, not the box count
+    void refresh();
+
+    bool isEmpty() const { return m_image.isNull(); }
+
+private:
+    // Longest side of the bin grid, the bin size grows with the level instead
+    static constexpr int kMaxBins = 512;
+
+    QRectF m_area;
+    QImage m_image;
+
+    qreal m_binSize = 1.0;
+    int m_columns = 0;
+    int m_rows = 0;
+    std::vector<quint32> m_counts;
+
+    quint32* binAt(const QPointF& centre);
+
+    static QRgb heatColour(float t);
+};
+
+#endif // DENSITYMAP_H
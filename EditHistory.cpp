@@ -0,0 +1,205 @@
+#include "EditHistory.h"
+
+void EditHistory::move(const std::vector<BoxHandle>& handles, const QVector3D& delta, bool merge) {
+    if (handles.empty() || delta.isNull()) return;
+
+    m_store->translate(handles, delta);
+
+    // A drag calls this once per mouse move, fold them into the step the drag started
+    if (merge && m_mergeOpen && !m_undo.empty()) {
+        Command& last = m_undo.back();
+        if (last.kind == Command::Move && last.handles == handles) {
+            last.delta += delta;
+            clearRedo();
+            return;
+        }
+    }
+
+    Command command{Command::Move, delta, handles, {}, {}};
+    push(std::move(command));
+    m_mergeOpen = merge;
+}
+
+void EditHistory::remove(std::vector<BoxHandle> handles) {
+    Command command{Command::Remove, QVector3D(), {}, {}, {}};
+    command.boxes.reserve(handles.size());
+
+    for (BoxHandle handle : handles) {
+        int index = m_store->indexOf(handle);
+        if (index < 0) continue;
+
+        command.boxes.push_back({handle, m_store->box(index), m_store->boxes().templateType(index)});
+    }
+    if (command.boxes.empty()) return;
+
+    removeBoxes(command.boxes);
+    push(std::move(command));
+}
+
+std::vector<BoxHandle> EditHistory::insert(const BoxArrays& boxes) {
+    std::vector<BoxHandle> handles;
+    if (boxes.isEmpty()) return handles;
+
+    // One bulk insert, the journal copy is only what redo needs to bring them back
+    handles = m_store->insert(boxes);
+
+    Command command{Command::Insert, QVector3D(), {}, {}, {}};
+    command.boxes.reserve(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        command.boxes.push_back({handles[i], boxes.box(i), boxes.templateType(i)});
+    }
+
+    push(std::move(command));
+    return handles;
+}
+
+void EditHistory::setBox(BoxHandle handle, const Rect3D& rect) {
+    int index = m_store->indexOf(handle);
+    if (index < 0) return;
+
+    std::array<GLfloat, 3> colour = rect.getColour();
+    const float values[] = {rect.x(), rect.y(), rect.z(), rect.width(), rect.height(), rect.depth(),
+                            colour[0], colour[1], colour[2]};
+
+    Command command{Command::Change, QVector3D(), {}, {}, {}};
+
+    // Only what actually changed, editing one field of a box keeps one field
+    for (int plane = BoxArrays::X; plane <= BoxArrays::Blue; ++plane) {
+        float before = m_store->boxes().value(index, BoxArrays::Plane(plane));
+        if (before == values[plane]) continue;
+
+        command.fields.push_back({handle, BoxArrays::Plane(plane), before, values[plane]});
+    }
+    if (command.fields.empty()) return;
+
+    apply(command, true);
+    push(std::move(command));
+}
+
+void EditHistory::setValue(const std::vector<BoxHandle>& handles, BoxArrays::Plane plane, float value) {
+    if (plane == BoxArrays::Selected) return;
+
+    Command command{Command::Change, QVector3D(), {}, {}, {}};
+
+    for (BoxHandle handle : handles) {
+        int index = m_store->indexOf(handle);
+        if (index < 0) continue;
+
+        float before = m_store->boxes().value(index, plane);
+        if (before != value) command.fields.push_back({handle, plane, before, value});
+    }
+    if (command.fields.empty()) return;
+
+    apply(command, true);
+    push(std::move(command));
+}
+
+bool EditHistory::undo() {
+    if (m_undo.empty()) return false;
+
+    Command command = std::move(m_undo.back());
+    m_undo.pop_back();
+
+    apply(command, false);
+    m_redo.push_back(std::move(command));
+    m_mergeOpen = false;
+    return true;
+}
+
+bool EditHistory::redo() {
+    if (m_redo.empty()) return false;
+
+    Command command = std::move(m_redo.back());
+    m_redo.pop_back();
+
+    apply(command, true);
+    m_undo.push_back(std::move(command));
+    m_mergeOpen = false;
+    return true;
+}
+
+void EditHistory::clear() {
+    m_undo.clear();
+    m_redo.clear();
+    m_bytes = 0;
+    m_mergeOpen = false;
+}
+
+size_t EditHistory::Command::bytes() const {
+    return sizeof(Command) + handles.capacity() * sizeof(BoxHandle) +
+           boxes.capacity() * sizeof(BoxRecord) + fields.capacity() * sizeof(FieldEdit);
+}
+
+void EditHistory::push(Command command) {
+    clearRedo();
+
+    m_bytes += command.bytes();
+    m_undo.push_back(std::move(command));
+    m_mergeOpen = false;
+
+    // Drop the oldest steps past the budget, the newest one stays even if it's bigger
+    while (m_bytes > kMaxBytes && m_undo.size() > 1) {
+        m_bytes -= m_undo.front().bytes();
+        m_undo.pop_front();
+    }
+}
+
+void EditHistory::clearRedo() {
+    for (const Command& step : m_redo) m_bytes -= step.bytes();
+    m_redo.clear();
+}
+
+void EditHistory::apply(const Command& command, bool forward) {
+    switch (command.kind) {
+    case Command::Move:
+        m_store->translate(command.handles, forward ? command.delta : -command.delta);
+        break;
+
+    case Command::Remove:
+        if (forward) removeBoxes(command.boxes);
+        else restoreBoxes(command.boxes);
+        break;
+
+    case Command::Insert:
+        if (forward) restoreBoxes(command.boxes);
+        else removeBoxes(command.boxes);
+        break;
+
+    case Command::Change:
+        // Backwards in reverse, so a box edited twice in one step ends up at its first value
+        if (forward) {
+            for (const FieldEdit& field : command.fields) m_store->setValue(field.handle, field.plane, field.after);
+        } else {
+            for (auto it = command.fields.rbegin(); it != command.fields.rend(); ++it) {
+                m_store->setValue(it->handle, it->plane, it->before);
+            }
+        }
+        break;
+    }
+}
+
+void EditHistory::removeBoxes(const std::vector<BoxRecord>& boxes) {
+    std::vector<BoxHandle> handles;
+    handles.reserve(boxes.size());
+    for (const BoxRecord& box : boxes) handles.push_back(box.handle);
+
+    // Out of the selection first, so it doesn't keep handles that may come back unselected
+    m_selection->remove(handles);
+
+    m_store->remove(handles);
+}
+
+void EditHistory::restoreBoxes(const std::vector<BoxRecord>& boxes) {
+    std::vector<BoxHandle> handles;
+    BoxArrays restored;
+    handles.reserve(boxes.size());
+    restored.reserve(boxes.size());
+
+    for (const BoxRecord& box : boxes) {
+        handles.push_back(box.handle);
+        restored.append(box.rect.position(), box.rect.size(), box.rect.getColour(), box.templateType);
+    }
+
+    // They all land at the end, so listeners hear of one inserted run
+    m_store->restore(handles, restored);
+}
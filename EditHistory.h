@@ -0,0 +1,91 @@
+#ifndef EDITHISTORY_H
+#define EDITHISTORY_H
+
+#include <QVector3D>
+#include <deque>
+#include <vector>
+#include "SceneStore.h"
+#include "Selection.h"
+
+// Undo and redo for box edits. Every edit goes through here, gets applied to the store and is
+// kept as the smallest delta that can replay it either way: a move is its handles and one
+// offset, a property edit only the fields that changed, and only removed or inserted boxes
+// are kept whole. Memory grows with the size of each edit, never with the size of the scene.
+class EditHistory {
+public:
+    EditHistory(SceneStore *store, Selection *selection) : m_store(store), m_selection(selection) {}
+
+    // Moves boxes by delta. With merge set, consecutive moves of the same boxes fold into one
+    // undo step until endMerge(), so a whole drag undoes at once.
+    void move(const std::vector<BoxHandle>& handles, const QVector3D& delta, bool merge = false);
+    void endMerge() { m_mergeOpen = false; }
+
+    // Takes a copy, the handles are often the selection, which this empties of them
+    void remove(std::vector<BoxHandle> handles);
+
+    // Adds every box of boxes as one undo step, handles in the same order
+    std::vector<BoxHandle> insert(const BoxArrays& boxes);
+
+    // Property edits. Selected isn't a property, it goes through Selection.
+    void setBox(BoxHandle handle, const Rect3D& rect);
+    void setValue(const std::vector<BoxHandle>& handles, BoxArrays::Plane plane, float value);
+
+    bool canUndo() const { return !m_undo.empty(); }
+    bool canRedo() const { return !m_redo.empty(); }
+
+    // False when there was nothing to undo or redo
+    bool undo();
+    bool redo();
+
+    // Call when the store is replaced, none of the recorded handles mean anything after
+    void clear();
+
+    // Bytes held by the undo and redo steps, kept under kMaxBytes by dropping the oldest
+    size_t memoryUsage() const { return m_bytes; }
+
+    static constexpr size_t kMaxBytes = 64 * 1024 * 1024;
+
+private:
+    // A removed or inserted box, whole, so it comes back under the same handle
+    struct BoxRecord {
+        BoxHandle handle;
+        Rect3D rect;
+        InternedString templateType;
+    };
+
+    struct FieldEdit {
+        BoxHandle handle;
+        BoxArrays::Plane plane;
+        float before;
+        float after;
+    };
+
+    struct Command {
+        enum Kind { Move, Remove, Insert, Change };
+
+        Kind kind;
+        QVector3D delta;                 // Move
+        std::vector<BoxHandle> handles;  // Move
+        std::vector<BoxRecord> boxes;    // Remove and Insert
+        std::vector<FieldEdit> fields;   // Change, in the order they were applied
+
+        size_t bytes() const;
+    };
+
+    SceneStore *m_store;
+    Selection *m_selection;
+
+    std::deque<Command> m_undo;
+    std::vector<Command> m_redo;
+    size_t m_bytes = 0;
+    bool m_mergeOpen = false;
+
+    void push(Command command);
+    void clearRedo();
+    void apply(const Command& command, bool forward);
+
+    void removeBoxes(const std::vector<BoxRecord>& boxes);
+    void restoreBoxes(const std::vector<BoxRecord>& boxes);
+};
+
+#endif // EDITHISTORY_H
@@ -0,0 +1,225 @@
+#include "FrameProfiler.h"
+#include <QDebug>
+#include <algorithm>
+
+void FrameProfiler::initialize(QOpenGLFunctions_3_3_Core *gl) {
+    m_gl = gl;
+
+    for (QuerySet& set : m_sets) {
+        m_gl->glGenQueries(static_cast<GLsizei>(set.queries.size()), set.queries.data());
+        set.pending = false;
+    }
+
+    m_frameTimer.start();
+}
+
+void FrameProfiler::release() {
+    if (!m_gl) return;
+
+    for (QuerySet& set : m_sets) {
+        m_gl->glDeleteQueries(static_cast<GLsizei>(set.queries.size()), set.queries.data());
+        set.queries.fill(0);
+        set.pending = false;
+    }
+
+    m_gl = nullptr;
+}
+
+const char* FrameProfiler::sectionName(Section section) {
+    switch (section) {
+    case ClearPass:    return "Clear/Fog";
+    case BoxPass:      return "Boxes";
+    case OutlinePass:  return "Outlines";
+    case DebugRayPass: return "Debug Ray";
+    case TextPass:     return "Text";
+    case InputPhase:   return "Input";
+    default:           return "?";
+    }
+}
+
+void FrameProfiler::beginFrame() {
+    if (!m_enabled || !m_gl) return;
+
+    QuerySet& set = m_sets[m_frameIndex % kQueryLatency];
+
+    // This set was issued kQueryLatency frames ago, so its results are normally ready
+    if (set.pending) collect(set, false);
+
+    set.issued.fill(false);
+    m_current = FrameStats();
+    m_frameTimer.restart();
+    m_inFrame = true;
+}
+
+void FrameProfiler::endFrame() {
+    if (!m_inFrame) return;
+
+    QuerySet& set = m_sets[m_frameIndex % kQueryLatency];
+
+    m_current.cpuTotalMs = m_frameTimer.nsecsElapsed() / 1.0e6;
+    set.stats = m_current;
+    set.pending = true;
+
+    m_frameIndex++;
+    m_inFrame = false;
+}
+
+void FrameProfiler::beginSection(Section section) {
+    if (!m_inFrame) return;
+
+    m_sectionStart[section] = m_frameTimer.nsecsElapsed();
+
+    if (hasGpuWork(section)) {
+        QuerySet& set = m_sets[m_frameIndex % kQueryLatency];
+        m_gl->glQueryCounter(set.queries[section * 2], GL_TIMESTAMP);
+    }
+}
+
+void FrameProfiler::endSection(Section section) {
+    if (!m_inFrame) return;
+
+    m_current.cpuMs[section] += (m_frameTimer.nsecsElapsed() - m_sectionStart[section]) / 1.0e6;
+
+    if (hasGpuWork(section)) {
+        QuerySet& set = m_sets[m_frameIndex % kQueryLatency];
+        m_gl->glQueryCounter(set.queries[section * 2 + 1], GL_TIMESTAMP);
+        set.issued[section] = true;
+    }
+}
+
+void FrameProfiler::finish() {
+    if (!m_gl) return;
+
+    // Oldest set first so lastFrame() ends up as the newest frame
+    for (int i = 0; i < kQueryLatency; ++i) {
+        QuerySet& set = m_sets[(m_frameIndex + i) % kQueryLatency];
+        if (set.pending) collect(set, true);
+    }
+}
+
+void FrameProfiler::collect(QuerySet& set, bool wait) {
+    set.pending = false;
+    set.stats.gpuValid = true;
+    set.stats.gpuTotalMs = 0.0;
+
+    for (int i = 0; i < SectionCount; ++i) {
+        if (!set.issued[i]) continue;
+
+        GLint available = 0;
+        m_gl->glGetQueryObjectiv(set.queries[i * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        // Unless finish() asked to wait, never block on the driver and drop GPU data for this frame instead
+        if (!available && !wait) {
+            set.stats.gpuValid = false;
+            break;
+        }
+
+        GLuint64 start = 0;
+        GLuint64 end = 0;
+        m_gl->glGetQueryObjectui64v(set.queries[i * 2], GL_QUERY_RESULT, &start);
+        m_gl->glGetQueryObjectui64v(set.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+        set.stats.gpuMs[i] = (end - start) / 1.0e6;
+        set.stats.gpuTotalMs += set.stats.gpuMs[i];
+    }
+
+    if (!set.stats.gpuValid) {
+        set.stats.gpuMs.fill(0.0);
+        set.stats.gpuTotalMs = 0.0;
+    }
+
+    m_last = set.stats;
+
+    m_cpuHistory[m_historyHead] = static_cast<float>(m_last.cpuTotalMs);
+    m_gpuHistory[m_historyHead] = static_cast<float>(m_last.gpuTotalMs);
+    m_historyHead = (m_historyHead + 1) % kHistorySize;
+}
+
+void FrameProfiler::drawOverlay(QPainter& painter, const QRect& area) const {
+    const int panelWidth = 300;
+    const int lineHeight = 16;
+    const int graphHeight = 60;
+    const int rows = SectionCount + 5;
+
+    QRect panel(area.right() - panelWidth - 10, area.top() + 10, panelWidth, rows * lineHeight + graphHeight + 20);
+
+    painter.save();
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(0, 0, 0, 170));
+    painter.drawRect(panel);
+
+    painter.setFont(QFont("Consolas", 9));
+    painter.setPen(Qt::white);
+
+    int x = panel.left() + 8;
+    int y = panel.top() + lineHeight;
+
+    painter.drawText(x, y, "Section");
+    painter.drawText(x + 130, y, "CPU ms");
+    painter.drawText(x + 210, y, "GPU ms");
+    y += lineHeight;
+
+    for (int i = 0; i < SectionCount; ++i) {
+        painter.drawText(x, y, sectionName(static_cast<Section>(i)));
+        painter.drawText(x + 130, y, QString::number(m_last.cpuMs[i], 'f', 3));
+
+        if (hasGpuWork(static_cast<Section>(i)) && m_last.gpuValid)
+            painter.drawText(x + 210, y, QString::number(m_last.gpuMs[i], 'f', 3));
+        else
+            painter.drawText(x + 210, y, "-");
+
+        y += lineHeight;
+    }
+
+    painter.drawText(x, y, "Total");
+    painter.drawText(x + 130, y, QString::number(m_last.cpuTotalMs, 'f', 3));
+    painter.drawText(x + 210, y, m_last.gpuValid ? QString::number(m_last.gpuTotalMs, 'f', 3) : "-");
+    y += lineHeight;
+
+    painter.drawText(x, y, QString("Draw calls: %1  Tris: %2").arg(m_last.drawCalls).arg(m_last.triangles));
+    y += lineHeight;
+    painter.drawText(x, y, QString("Culled: %1").arg(m_last.culled));
+    y += lineHeight;
+
+    if (m_last.gpuValid) {
+        bool gpuBound = m_last.gpuTotalMs > m_last.cpuTotalMs;
+        painter.setPen(gpuBound ? QColor(255, 160, 0) : QColor(0, 200, 255));
+        painter.drawText(x, y, gpuBound ? "GPU-bound" : "CPU-bound");
+    }
+    y += lineHeight / 2;
+
+    // Rolling history graph, CPU in blue and GPU in orange
+    QRect graph(x, y, panelWidth - 16, graphHeight);
+
+    float maxMs = 16.7f;
+    for (int i = 0; i < kHistorySize; ++i) {
+        maxMs = std::max({maxMs, m_cpuHistory[i], m_gpuHistory[i]});
+    }
+
+    painter.setPen(QColor(80, 80, 80));
+    painter.setBrush(Qt::NoBrush);
+    painter.drawRect(graph);
+
+    auto plot = [&](const std::array<float, kHistorySize>& history, const QColor& colour) {
+        QPolygonF line;
+        line.reserve(kHistorySize);
+
+        for (int i = 0; i < kHistorySize; ++i) {
+            float value = history[(m_historyHead + i) % kHistorySize];
+            float px = graph.left() + graph.width() * (i / float(kHistorySize - 1));
+            float py = graph.bottom() - graph.height() * (value / maxMs);
+            line << QPointF(px, py);
+        }
+
+        painter.setPen(colour);
+        painter.drawPolyline(line);
+    };
+
+    plot(m_cpuHistory, QColor(0, 200, 255));
+    plot(m_gpuHistory, QColor(255, 160, 0));
+
+    painter.setPen(Qt::gray);
+    painter.drawText(graph.left() + 2, graph.top() + lineHeight - 4, QString("%1 ms").arg(maxMs, 0, 'f', 1));
+
+    painter.restore();
+}
@@ -0,0 +1,96 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QElapsedTimer>
+#include <QPainter>
+#include <array>
+
+// Per-frame CPU/GPU profiler for the 3D view.
+// GPU times come from GL timestamp queries which are read back a few frames
+// later, so the overlay never stalls the pipeline waiting on results.
+class FrameProfiler {
+public:
+    enum Section {
+        ClearPass,
+        BoxPass,
+        OutlinePass,
+        DebugRayPass,
+        TextPass,
+        InputPhase,     // CPU only, no GL work is issued here
+        SectionCount
+    };
+
+    struct FrameStats {
+        std::array<double, SectionCount> cpuMs = {};
+        std::array<double, SectionCount> gpuMs = {};
+        double cpuTotalMs = 0.0;
+        double gpuTotalMs = 0.0;
+        bool gpuValid = false;
+        int drawCalls = 0;
+        int triangles = 0;
+        int culled = 0;
+    };
+
+    static constexpr int kQueryLatency = 4;     // Frames in flight before reading a query back
+    static constexpr int kHistorySize = 120;    // Frames kept for the rolling graph
+
+    FrameProfiler() = default;
+
+    // Must be called with the owning context current
+    void initialize(QOpenGLFunctions_3_3_Core *gl);
+    void release();
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() const { return m_enabled; }
+
+    void beginFrame();
+    void endFrame();
+
+    // Blocks until every frame still in flight has its GPU times, for offline benchmarks
+    void finish();
+
+    void beginSection(Section section);
+    void endSection(Section section);
+
+    void addDrawCall(int triangles) { m_current.drawCalls++; m_current.triangles += triangles; }
+    void addCulled(int count = 1) { m_current.culled += count; }
+
+    // Most recent frame with complete CPU and GPU data
+    const FrameStats& lastFrame() const { return m_last; }
+
+    void drawOverlay(QPainter& painter, const QRect& area) const;
+
+    static const char* sectionName(Section section);
+
+private:
+    struct QuerySet {
+        std::array<GLuint, SectionCount * 2> queries = {};
+        std::array<bool, SectionCount> issued = {};
+        FrameStats stats;
+        bool pending = false;
+    };
+
+    static bool hasGpuWork(Section section) { return section != InputPhase; }
+
+    void collect(QuerySet& set, bool wait);
+
+    QOpenGLFunctions_3_3_Core *m_gl = nullptr;
+    bool m_enabled = false;
+    bool m_inFrame = false;
+
+    std::array<QuerySet, kQueryLatency> m_sets;
+    int m_frameIndex = 0;
+
+    QElapsedTimer m_frameTimer;
+    std::array<qint64, SectionCount> m_sectionStart = {};
+
+    FrameStats m_current;
+    FrameStats m_last;
+
+    std::array<float, kHistorySize> m_cpuHistory = {};
+    std::array<float, kHistorySize> m_gpuHistory = {};
+    int m_historyHead = 0;
+};
+
+#endif // FRAMEPROFILER_H
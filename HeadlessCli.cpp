@@ -0,0 +1,450 @@
+#include "HeadlessCli.h"
+#include "OffscreenRenderer.h"
+#include "LevelLoader.h"
+#include "CameraPath.h"
+#include "LoadArena.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+struct LoadedAsset {
+    SceneStore store;
+    bool hasFog = false;
+    std::array<float, 4> lowerFog;
+    std::array<float, 4> upperFog;
+};
+
+// Same layout rules as the editor's Open menu
+bool loadAsset(const QString& type, const QString& path, const QString& rootDir, LoadedAsset& asset) {
+    // The file data is only needed to place the boxes, the arena frees all of it on return
+    LoadArena arena;
+    std::pmr::memory_resource* resource = arena.resource();
+
+    if (type == "segment") {
+        Segment segment = Loader::loadLevelSegment(rootDir, path, false, resource);
+        asset.store.assign(Loader::getBoxArrays(segment.boxes));
+    } else if (type == "room") {
+        Room room = Loader::LoadRoom(path, rootDir, resource);
+        asset.store.assign(Loader::placeRoomBoxes(room));
+        asset.hasFog = true;
+        asset.lowerFog = room.lowerFog;
+        asset.upperFog = room.upperFog;
+    } else if (type == "level") {
+        Level level = Loader::loadLevel(path, rootDir, false, false, resource);
+        asset.store.assign(Loader::placeLevelBoxes(level));
+        if (!level.rooms.empty()) {
+            asset.hasFog = true;
+            asset.lowerFog = level.rooms.front().lowerFog;
+            asset.upperFog = level.rooms.front().upperFog;
+        }
+    } else if (type == "game") {
+        LevelList levels = Loader::loadGame("/game.xml", rootDir, resource);
+        asset.store.assign(Loader::placeGameBoxes(levels));
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+QString guessAssetType(const QString& path) {
+    return QFileInfo(path).suffix().toLower() == "lua" ? "room" : "segment";
+}
+
+bool parseSize(const QString& text, QSize& size) {
+    QStringList parts = text.toLower().split('x');
+    if (parts.size() != 2) return false;
+
+    bool okW = false, okH = false;
+    size = QSize(parts[0].toInt(&okW), parts[1].toInt(&okH));
+    return okW && okH && size.width() > 0 && size.height() > 0;
+}
+
+// "x,y,z" or "x,y,z,yaw,pitch"
+bool parseCamera(const QString& text, RenderCamera& camera) {
+    QStringList parts = text.split(',');
+    if (parts.size() != 3 && parts.size() != 5) return false;
+
+    camera.position = QVector3D(parts[0].toFloat(), parts[1].toFloat(), parts[2].toFloat());
+
+    if (parts.size() == 5) {
+        camera.yaw = parts[3].toFloat();
+        camera.pitch = parts[4].toFloat();
+    }
+
+    return true;
+}
+
+int runRender(const QCommandLineParser& parser, const QString& rootDir) {
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QString path = parser.value("render");
+    QString type = parser.isSet("type") ? parser.value("type") : guessAssetType(path);
+
+    QSize size(640, 360);
+    if (parser.isSet("size") && !parseSize(parser.value("size"), size)) {
+        err << "Invalid --size, expected WxH\n";
+        return 1;
+    }
+
+    RenderCamera camera;
+    camera.fov = parser.value("fov").toFloat();
+
+    if (parser.isSet("camera") && !parseCamera(parser.value("camera"), camera)) {
+        err << "Invalid --camera, expected x,y,z[,yaw,pitch]\n";
+        return 1;
+    }
+
+    if (parser.isSet("game-view")) {
+        camera.gameView = true;
+        camera.gameViewPosition = parser.value("game-view").toFloat();
+    }
+
+    int frames = std::max(1, parser.value("frames").toInt());
+
+    LoadedAsset asset;
+    if (!loadAsset(type, path, rootDir, asset)) {
+        err << "Unknown asset type " << type << ", expected segment, room, level or game\n";
+        return 1;
+    }
+
+    RenderOptions options;
+    if (asset.hasFog) {
+        options.lowerFogColour = asset.lowerFog;
+        options.upperFogColour = asset.upperFog;
+    }
+
+    OffscreenRenderer renderer;
+    if (!renderer.create(size, rootDir)) {
+        err << "Could not create an offscreen OpenGL context\n";
+        return 1;
+    }
+    renderer.renderer().sceneBuffers().setCompact(parser.isSet("compact"));
+
+    Selection noSelection(&asset.store);
+    std::vector<double> cpuTimes;
+    std::vector<double> gpuTimes;
+
+    for (int i = 0; i < frames; ++i) {
+        renderer.renderFrame(asset.store, noSelection, camera, options);
+
+        const FrameProfiler::FrameStats& stats = renderer.lastFrame();
+        cpuTimes.push_back(stats.cpuTotalMs);
+        if (stats.gpuValid) gpuTimes.push_back(stats.gpuTotalMs);
+
+        out << QString("frame %1: cpu %2 ms, gpu %3 ms, draws %4, culled %5\n")
+                   .arg(i)
+                   .arg(stats.cpuTotalMs, 0, 'f', 3)
+                   .arg(stats.gpuValid ? QString::number(stats.gpuTotalMs, 'f', 3) : QString("n/a"))
+                   .arg(stats.drawCalls)
+                   .arg(stats.culled);
+    }
+
+    auto summary = [&](const char* name, const std::vector<double>& times) {
+        if (times.empty()) return;
+        double total = 0.0;
+        for (double t : times) total += t;
+        out << QString("%1: min %2 ms, avg %3 ms, max %4 ms\n")
+                   .arg(name)
+                   .arg(*std::min_element(times.begin(), times.end()), 0, 'f', 3)
+                   .arg(total / times.size(), 0, 'f', 3)
+                   .arg(*std::max_element(times.begin(), times.end()), 0, 'f', 3);
+    };
+
+    out << QString("%1 boxes, %2 frames at %3x%4\n").arg(asset.store.size()).arg(frames).arg(size.width()).arg(size.height());
+    const SceneBuffers& buffers = renderer.renderer().sceneBuffers();
+    out << QString("instance data: %1 bytes, %2 layout\n").arg(buffers.uploadedBytes()).arg(buffers.isCompact() ? "compact" : "float");
+    summary("cpu", cpuTimes);
+    summary("gpu", gpuTimes);
+
+    if (parser.isSet("out")) {
+        QString outPath = parser.value("out");
+        if (!renderer.grabImage().save(outPath)) {
+            err << "Failed to write " << outPath << "\n";
+            return 1;
+        }
+        out << "Wrote " << outPath << "\n";
+    }
+
+    return 0;
+}
+
+// Nearest-rank percentiles over a sorted copy
+QJsonObject timingSummary(std::vector<double> times) {
+    QJsonObject summary;
+    if (times.empty()) return summary;
+
+    std::sort(times.begin(), times.end());
+
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * times.size()));
+        return times[std::clamp<size_t>(rank, 1, times.size()) - 1];
+    };
+
+    double total = 0.0;
+    for (double t : times) total += t;
+
+    summary["samples"] = static_cast<int>(times.size());
+    summary["min"] = times.front();
+    summary["mean"] = total / times.size();
+    summary["p50"] = percentile(50);
+    summary["p90"] = percentile(90);
+    summary["p95"] = percentile(95);
+    summary["p99"] = percentile(99);
+    summary["max"] = times.back();
+    return summary;
+}
+
+int runBenchmark(const QCommandLineParser& parser, const QString& rootDir) {
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QString path = parser.value("benchmark");
+    QString type = parser.isSet("type") ? parser.value("type") : QString("level");
+
+    QSize size(640, 360);
+    if (parser.isSet("size") && !parseSize(parser.value("size"), size)) {
+        err << "Invalid --size, expected WxH\n";
+        return 1;
+    }
+
+    LoadedAsset asset;
+    if (!loadAsset(type, path, rootDir, asset)) {
+        err << "Unknown asset type " << type << ", expected segment, room, level or game\n";
+        return 1;
+    }
+
+    // A recorded path replays exactly, otherwise run the game view down the whole scene
+    CameraPath cameraPath;
+    if (parser.isSet("path")) {
+        if (!cameraPath.load(parser.value("path"))) {
+            err << "Could not read camera path " << parser.value("path") << "\n";
+            return 1;
+        }
+    } else {
+        int frames = parser.isSet("frames") ? parser.value("frames").toInt() : 600;
+        cameraPath = CameraPath::gameRun(asset.store.boxes(), frames, parser.value("fov").toFloat());
+    }
+
+    if (cameraPath.isEmpty()) {
+        err << "Camera path has no frames\n";
+        return 1;
+    }
+
+    RenderOptions options;
+    if (asset.hasFog) {
+        options.lowerFogColour = asset.lowerFog;
+        options.upperFogColour = asset.upperFog;
+    }
+    options.drawDebugRay = false;
+
+    OffscreenRenderer renderer;
+    if (!renderer.create(size, rootDir)) {
+        err << "Could not create an offscreen OpenGL context\n";
+        return 1;
+    }
+    renderer.renderer().sceneBuffers().setCompact(parser.isSet("compact"));
+
+    Selection noSelection(&asset.store);
+
+    // Warm up on the first camera so shader compiles and texture uploads stay out of the numbers
+    int warmup = std::max(0, parser.value("warmup").toInt());
+    for (int i = 0; i < warmup; ++i) {
+        renderer.renderFrame(asset.store, noSelection, cameraPath.at(0), options);
+    }
+
+    std::vector<double> cpuTimes;
+    std::vector<double> gpuTimes;
+    QJsonArray frames;
+
+    cpuTimes.reserve(cameraPath.size());
+    gpuTimes.reserve(cameraPath.size());
+
+    for (size_t i = 0; i < cameraPath.size(); ++i) {
+        renderer.renderFrame(asset.store, noSelection, cameraPath.at(i), options);
+
+        const FrameProfiler::FrameStats& stats = renderer.lastFrame();
+        cpuTimes.push_back(stats.cpuTotalMs);
+        if (stats.gpuValid) gpuTimes.push_back(stats.gpuTotalMs);
+
+        QJsonObject frame;
+        frame["cpu"] = stats.cpuTotalMs;
+        frame["gpu"] = stats.gpuValid ? QJsonValue(stats.gpuTotalMs) : QJsonValue();
+        frame["drawCalls"] = stats.drawCalls;
+        frame["culled"] = stats.culled;
+        frames.append(frame);
+    }
+
+    QJsonObject result;
+    result["asset"] = path;
+    result["type"] = type;
+    result["boxes"] = static_cast<int>(asset.store.size());
+    result["width"] = size.width();
+    result["height"] = size.height();
+    result["path"] = parser.isSet("path") ? parser.value("path") : QString("generated");
+    result["frames"] = static_cast<int>(cameraPath.size());
+    result["warmup"] = warmup;
+    result["glRenderer"] = renderer.glRendererName();
+    result["compactBoxes"] = renderer.renderer().sceneBuffers().isCompact();
+    result["instanceBytes"] = static_cast<double>(renderer.renderer().sceneBuffers().uploadedBytes());
+    result["cpuMs"] = timingSummary(cpuTimes);
+    result["gpuMs"] = gpuTimes.empty() ? QJsonValue() : QJsonValue(timingSummary(gpuTimes));
+    if (parser.isSet("per-frame")) result["perFrame"] = frames;
+
+    QByteArray json = QJsonDocument(result).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet("json")) {
+        QFile file(parser.value("json"));
+        if (!file.open(QIODevice::WriteOnly)) {
+            err << "Failed to write " << parser.value("json") << "\n";
+            return 1;
+        }
+        file.write(json);
+        out << "Wrote " << parser.value("json") << "\n";
+    } else {
+        out << json;
+    }
+
+    return 0;
+}
+
+bool writeFile(const QString& path, const QString& text) {
+    QDir().mkpath(QFileInfo(path).path());
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+    return file.write(text.toUtf8()) >= 0;
+}
+
+QString segmentXml(int boxes) {
+    QString xml = "<segment size=\"12 10 8\">\n";
+    for (int i = 0; i < boxes; ++i) {
+        xml += QString("\t<box pos=\"%1 0 -2\" size=\"1 1 1\" template=\"selftest\"/>\n").arg(i * 2);
+    }
+    return xml + "</segment>\n";
+}
+
+// A root directory with one of everything the loaders read: start, middle and door segments,
+// a room using them, a level with the room twice and a game with the level
+bool writeFixture(const QString& root) {
+    return writeFile(root + "/templates.xml",
+                     "<templates>\n\t<template name=\"selftest\">\n\t\t<properties color=\"0.5 0.5 0.5\"/>\n"
+                     "\t</template>\n</templates>\n") &&
+           writeFile(root + "/segments/selftest/start.xml", segmentXml(2)) &&
+           writeFile(root + "/segments/selftest/middle.xml", segmentXml(3)) &&
+           writeFile(root + "/segments/selftest/door.xml", segmentXml(1)) &&
+           writeFile(root + "/rooms/selftest.lua",
+                     "function init()\n\tmgFogColor(0.1, 0.2, 0.3, 0.4, 0.5, 0.6)\n"
+                     "\tconfSegment(\"selftest/start\", 1)\n\tconfSegment(\"selftest/middle\", 1)\n"
+                     "\tconfSegment(\"selftest/door\", 1)\nend\n") &&
+           writeFile(root + "/levels/selftest.xml", "<level>\n\t<room type=\"selftest\"/>\n\t<room type=\"selftest\"/>\n</level>\n") &&
+           writeFile(root + "/game.xml", "<game>\n\t<level name=\"selftest\"/>\n</game>\n");
+}
+
+// Loads a generated fixture of every asset type and fails if a Box or a BoxArrays was copied on the
+// way into the store. Each box must be built once by the parser and once into the store's arrays.
+int runSelfTest() {
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QTemporaryDir dir;
+    if (!dir.isValid() || !writeFixture(dir.path())) {
+        err << "Could not write the self-test fixture\n";
+        return 1;
+    }
+    QString root = dir.path();
+
+    struct Case {
+        QString type;
+        QString path;
+        size_t boxes;
+    };
+
+    const Case cases[] = {
+        {"segment", root + "/segments/selftest/middle.xml", 3},
+        {"room", root + "/rooms/selftest.lua", 6},
+        {"level", root + "/levels/selftest.xml", 12},
+        {"game", QString(), 12},
+    };
+
+    int failures = 0;
+
+    for (const Case& test : cases) {
+        CopyCounter<Box>::reset();
+        CopyCounter<BoxArrays>::reset();
+
+        LoadedAsset asset;
+        loadAsset(test.type, test.path, root, asset);
+
+        quint64 boxCopies = CopyCounter<Box>::copies();
+        quint64 arrayCopies = CopyCounter<BoxArrays>::copies();
+        bool passed = asset.store.size() == test.boxes && boxCopies == 0 && arrayCopies == 0;
+        if (!passed) ++failures;
+
+        out << (passed ? "PASS " : "FAIL ") << test.type << ": " << asset.store.size() << " of " << test.boxes
+            << " boxes, " << boxCopies << " Box copies, " << arrayCopies << " BoxArrays copies\n";
+    }
+
+    return failures ? 1 : 0;
+}
+
+} // namespace
+
+bool Headless::isHeadlessRun(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--render") == 0 || qstrcmp(argv[i], "--benchmark") == 0 ||
+            qstrcmp(argv[i], "--self-test") == 0) return true;
+    }
+    return false;
+}
+
+int Headless::run(const QStringList& arguments) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Smash Hit DevKit headless renderer");
+    parser.addHelpOption();
+
+    parser.addOption({"render", "Render the asset at <path> to an image.", "path"});
+    parser.addOption({"type", "Asset type: segment, room, level or game. Guessed from the extension if omitted.", "type"});
+    parser.addOption({"root", "Game asset root directory. Defaults to the editor's root directory.", "dir"});
+    parser.addOption({"out", "PNG file to write the last frame to.", "file"});
+    parser.addOption({"size", "Image size as WxH.", "size", "640x360"});
+    parser.addOption({"camera", "Free camera as x,y,z[,yaw,pitch].", "camera"});
+    parser.addOption({"game-view", "Use the game view camera at this distance.", "position"});
+    parser.addOption({"fov", "Field of view in degrees.", "fov", "75"});
+    parser.addOption({"frames", "Number of frames to render for timing.", "count", "1"});
+
+    parser.addOption({"benchmark", "Fly the camera through the level (or game with --type game) at <path> and report frame times.", "path"});
+    parser.addOption({"path", "Camera path recorded with F10 in the 3D view. Defaults to a game view run over the whole scene.", "file"});
+    parser.addOption({"warmup", "Frames rendered before timing starts.", "count", "10"});
+    parser.addOption({"json", "File to write the benchmark results to instead of stdout.", "file"});
+    parser.addOption({"per-frame", "Include every frame's timings in the benchmark results."});
+    parser.addOption({"compact", "Upload boxes in the 16-byte compact layout when the scene fits it."});
+
+    parser.addOption({"self-test", "Load a generated fixture of every asset type and exit non-zero if a box was copied on the way."});
+
+    parser.process(arguments);
+
+    if (parser.isSet("self-test")) return runSelfTest();
+
+    QString rootDir = parser.value("root");
+    if (rootDir.isEmpty()) {
+        QSettings settings("settings.ini", QSettings::Format::IniFormat);
+        rootDir = settings.value("Editor.rootDir", "C:/").toString();
+    }
+
+    if (parser.isSet("benchmark")) return runBenchmark(parser, rootDir);
+
+    return runRender(parser, rootDir);
+}
@@ -0,0 +1,14 @@
+#ifndef HEADLESSCLI_H
+#define HEADLESSCLI_H
+
+#include <QStringList>
+
+// Command line entry points that render without opening the editor window
+namespace Headless {
+    // Checked before QApplication exists so the offscreen platform can be selected
+    bool isHeadlessRun(int argc, char *argv[]);
+
+    int run(const QStringList& arguments);
+}
+
+#endif // HEADLESSCLI_H
@@ -0,0 +1,65 @@
+#include "InternedString.h"
+#include <QHash>
+#include <QReadWriteLock>
+#include <deque>
+
+namespace {
+
+struct StringTable {
+    QReadWriteLock lock;
+    QHash<QString, quint32> ids;
+    std::deque<QString> strings;  // A deque so toString() references survive later inserts
+
+    StringTable() {
+        strings.emplace_back();
+        ids.insert(QString(), 0);
+    }
+};
+
+StringTable& table() {
+    static StringTable instance;
+    return instance;
+}
+
+}
+
+InternedString::InternedString(QStringView text) {
+    if (text.isEmpty()) return;
+
+    StringTable& t = table();
+    QString key = text.toString();
+
+    {
+        QReadLocker reader(&t.lock);
+        auto it = t.ids.constFind(key);
+        if (it != t.ids.cend()) {
+            m_id = it.value();
+            return;
+        }
+    }
+
+    QWriteLocker writer(&t.lock);
+
+    // Another thread may have added it between the two locks
+    auto it = t.ids.constFind(key);
+    if (it != t.ids.cend()) {
+        m_id = it.value();
+        return;
+    }
+
+    m_id = static_cast<quint32>(t.strings.size());
+    t.strings.push_back(key);
+    t.ids.insert(key, m_id);
+}
+
+const QString& InternedString::toString() const {
+    StringTable& t = table();
+    QReadLocker reader(&t.lock);
+    return t.strings[m_id];
+}
+
+quint32 InternedString::count() {
+    StringTable& t = table();
+    QReadLocker reader(&t.lock);
+    return static_cast<quint32>(t.strings.size());
+}
@@ -0,0 +1,32 @@
+#ifndef INTERNEDSTRING_H
+#define INTERNEDSTRING_H
+
+#include <QString>
+#include <QStringView>
+
+// A string kept once in a process-wide table and carried around as its index. Template and
+// obstacle names come from a few dozen distinct values, so boxes hold four bytes instead of a
+// QString each, equality is an integer compare, and id() can index per-name lookup tables.
+// The table only grows, so an id stays valid for the life of the process.
+class InternedString {
+public:
+    // The empty string, always id 0
+    InternedString() = default;
+    explicit InternedString(QStringView text);
+
+    quint32 id() const { return m_id; }
+    bool isEmpty() const { return m_id == 0; }
+
+    const QString& toString() const;
+
+    // Ids handed out so far, an upper bound for tables indexed by id()
+    static quint32 count();
+
+    bool operator==(InternedString other) const { return m_id == other.m_id; }
+    bool operator!=(InternedString other) const { return m_id != other.m_id; }
+
+private:
+    quint32 m_id = 0;
+};
+
+#endif // INTERNEDSTRING_H
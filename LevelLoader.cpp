@@ -1,10 +1,12 @@
 #include "LevelLoader.h"
 #include <QFile>
 #include <QFileInfo>
+#include <optional>
 #include <qxmlstream.h>
 
-Level Loader::loadLevel(const QString& levelPath, const QString& rootDir, const bool appendStr, const bool useRoot) {
-    Level level;
+Level Loader::loadLevel(const QString& levelPath, const QString& rootDir, const bool appendStr, const bool useRoot,
+                        std::pmr::memory_resource* resource, const TemplateTable* templates) {
+    Level level(resource);
     level.name = extractFileName(levelPath);
 
     QString filename;
@@ -22,6 +24,9 @@ Level Loader::loadLevel(const QString& levelPath, const QString& rootDir, const
 
     QXmlStreamReader xml(&file);
 
+    std::optional<TemplateTable> ownTemplates;
+    if (!templates) templates = &ownTemplates.emplace(rootDir);
+
     while (!xml.atEnd() && !xml.hasError()) {
         xml.readNext();
 
@@ -33,8 +38,7 @@ Level Loader::loadLevel(const QString& levelPath, const QString& rootDir, const
 
                 if (!typeAttr.isEmpty()) {
                     QString luaPath = rootDir + "/rooms/" + typeAttr + ".lua";
-                    Room room = LoadRoom(luaPath, rootDir);
-                    level.rooms.push_back(room);
+                    level.rooms.push_back(LoadRoom(luaPath, rootDir, resource, templates));
                 } else {
                     qWarning() << "Room element is missing 'type' attribute!";
                 }
@@ -49,8 +53,8 @@ Level Loader::loadLevel(const QString& levelPath, const QString& rootDir, const
     return level;
 }
 
-std::vector<Level> Loader::loadGame(const QString& gamePath, const QString& rootDir) {
-    std::vector<Level> levels;
+LevelList Loader::loadGame(const QString& gamePath, const QString& rootDir, std::pmr::memory_resource* resource) {
+    LevelList levels(resource);
 
     QString realPath = rootDir + gamePath;
 
@@ -62,6 +66,9 @@ std::vector<Level> Loader::loadGame(const QString& gamePath, const QString& root
 
     QXmlStreamReader xml(&file);
 
+    // Read once for the whole game
+    TemplateTable templates(rootDir);
+
     while (!xml.atEnd() && !xml.hasError()) {
         xml.readNext();
 
@@ -72,12 +79,71 @@ std::vector<Level> Loader::loadGame(const QString& gamePath, const QString& root
 
                 QString levelName = xml.attributes().value("name").toString();
 
-                Level newLevel = loadLevel(levelName, rootDir, true, true);
-
-                levels.push_back(newLevel);
+                levels.push_back(loadLevel(levelName, rootDir, true, true, resource, &templates));
             }
         }
     }
 
     return levels;
 }
+
+BoxArrays Loader::placeRoomBoxes(const Room& room) {
+    BoxArrays boxes;
+
+    for (const Segment& seg : room.segments) {
+        qDebug() << "Segment offset: " << seg.offset;
+
+        size_t first = boxes.size();
+        appendBoxes(boxes, seg.boxes);
+        boxes.translate(first, boxes.size(), QVector3D(0, 0, -seg.offset));
+    }
+
+    if (!room.segments.empty()) qDebug() << "Final segment offset: " << room.segments.back().offset;
+
+    return boxes;
+}
+
+BoxArrays Loader::placeLevelBoxes(const Level& level) {
+    float totalOffset = 0.0f;
+    BoxArrays boxes;
+
+    for (const Room& room : level.rooms) {
+        for (const Segment& segment : room.segments) {
+            // Apply global room+segment offset to boxes
+            size_t first = boxes.size();
+            appendBoxes(boxes, segment.boxes);
+            boxes.translate(first, boxes.size(), QVector3D(0, 0, -(totalOffset + segment.offset)));
+        }
+
+        // Increase total offset by the total room length
+        if (!room.segments.empty()) {
+            const Segment& lastSeg = room.segments.back();
+            totalOffset += lastSeg.offset + lastSeg.size.z();
+        }
+    }
+
+    return boxes;
+}
+
+BoxArrays Loader::placeGameBoxes(const LevelList& levels) {
+    float totalOffset = 0.0f;
+    BoxArrays boxes;
+
+    for (const Level& level : levels) {
+        for (const Room& room : level.rooms) {
+            for (const Segment& segment : room.segments) {
+                // Apply cumulative offset for the entire game's room/segment structure
+                size_t first = boxes.size();
+                appendBoxes(boxes, segment.boxes);
+                boxes.translate(first, boxes.size(), QVector3D(0, 0, -totalOffset));
+
+                // Increase totalOffset by segment size
+                totalOffset += segment.size.z();
+            }
+        }
+    }
+
+    qDebug() << "Total game length:" << totalOffset;
+
+    return boxes;
+}
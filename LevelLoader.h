@@ -5,14 +5,35 @@
 #include "RoomLoader.h"
 
 struct Level {
+    explicit Level(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : rooms(resource) {}
+
+    Level(Level&&) = default;
+    Level& operator=(Level&&) = default;
+    Level(const Level&) = delete;
+    Level& operator=(const Level&) = delete;
+
     QString name;
-    std::vector<Room> rooms;
+    std::pmr::vector<Room> rooms;
 };
 
+using LevelList = std::pmr::vector<Level>;
+
 namespace Loader {
-    Level loadLevel(const QString& levelPath, const QString& rootDir, const bool appendStr, const bool useRoot);
+    // Everything read is allocated from resource, pass a LoadArena's to free a load in one release.
+    // Without templates, the level reads rootDir's table once for all its rooms.
+    Level loadLevel(const QString& levelPath, const QString& rootDir, const bool appendStr, const bool useRoot,
+                    std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                    const TemplateTable* templates = nullptr);
+
+    LevelList loadGame(const QString& gamePath, const QString& rootDir,
+                       std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
-    std::vector<Level> loadGame(const QString& gamePath, const QString& rootDir);
+    // All boxes as one set of arrays, each segment's boxes shifted by its offset in one bulk move.
+    // The segments themselves keep their file positions.
+    BoxArrays placeRoomBoxes(const Room& room);
+    BoxArrays placeLevelBoxes(const Level& level);
+    BoxArrays placeGameBoxes(const LevelList& levels);
 }
 
 #endif // LEVELLOADER_H
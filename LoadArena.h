@@ -0,0 +1,59 @@
+#ifndef LOADARENA_H
+#define LOADARENA_H
+
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// Bump allocator for the Segment, Room and Level lists of one load. Frees are no-ops and the
+// whole load goes back to the heap at once when the arena is destroyed.
+// Strings stay on the normal heap, QString has no allocator hook.
+class LoadArena {
+public:
+    explicit LoadArena(size_t initialSize = 64 * 1024) : m_resource(initialSize) {}
+
+    LoadArena(const LoadArena&) = delete;
+    LoadArena& operator=(const LoadArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &m_resource; }
+
+private:
+    std::pmr::monotonic_buffer_resource m_resource;
+};
+
+// A loaded value kept together with the arena it was built in, so it can't outlive its memory.
+// Loaded data must be moved, never copied: a copied pmr container falls back to the default heap.
+template <typename T>
+class ArenaValue {
+public:
+    // Builds a new value with build(resource) in a fresh arena, then drops the old value and
+    // releases its arena in one go
+    template <typename Build>
+    T& load(Build build) {
+        auto arena = std::make_unique<LoadArena>();
+        T value = build(arena->resource());
+
+        m_value.reset();
+        m_value.emplace(std::move(value));  // Move construction keeps the new arena's allocator
+        m_arena = std::move(arena);
+        return *m_value;
+    }
+
+    void reset() {
+        m_value.reset();
+        m_arena.reset();
+    }
+
+    bool isLoaded() const { return m_value.has_value(); }
+
+    T& operator*() { return *m_value; }
+    const T& operator*() const { return *m_value; }
+    T* operator->() { return &*m_value; }
+    const T* operator->() const { return &*m_value; }
+
+private:
+    std::unique_ptr<LoadArena> m_arena;  // Declared first so the value is destroyed before it
+    std::optional<T> m_value;
+};
+
+#endif // LOADARENA_H
@@ -17,19 +17,38 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), m_option(ViewOpti
 
     prefs = loadPrefs();
 
-    xyView = new XYViewWidget(this, &m_rects, &m_selectedRects, &m_option);
-    xzView = new XZViewWidget(this, &m_rects, &m_selectedRects, &m_option);
-    yzView = new YZViewWidget(this, &m_rects, &m_selectedRects, &m_option);
+    xyView = new XYViewWidget(this, &m_store, &m_selection, &m_option);
+    xzView = new XZViewWidget(this, &m_store, &m_selection, &m_option);
+    yzView = new YZViewWidget(this, &m_store, &m_selection, &m_option);
 
-    segmentWidget = new SegmentWidget(this, &m_rects, &m_selectedRects);  // 3D view widget
+    segmentWidget = new SegmentWidget(this, &m_store, &m_selection);  // 3D view widget
+
+    // Box geometry is uploaded once and drawn by all four views, then patched as the store changes
+    m_sceneBuffers.watch(&m_store);
+    segmentWidget->setSceneBuffers(&m_sceneBuffers);
+
+    m_repaintScheduler = new RepaintScheduler(this);
+    segmentWidget->setRepaintScheduler(m_repaintScheduler);
+
+    for (BaseViewWidget *view : std::initializer_list<BaseViewWidget*>{xyView, xzView, yzView}) {
+        view->setSceneBuffers(&m_sceneBuffers);
+        view->setRepaintScheduler(m_repaintScheduler);
+        view->setEditHistory(&m_history);
+        connect(view, &BaseViewWidget::rectsEdited, this, &MainWindow::rectsChanged);
+        connect(view, &BaseViewWidget::selectionEdited, this, &MainWindow::updateAllViews);
+    }
 
     segmentWidget->setRootDir(prefs.m_rootDir);
     segmentWidget->setFov(prefs.m_fov);
     segmentWidget->setSens(prefs.m_sensitivity);
 
-    outliner = new QTreeWidget;
-    outliner->setColumnCount(1); // Only one column for display
-    outliner->setHeaderHidden(true); 
+    // Rows are made and formatted as they're expanded and scrolled to, so a whole game opens instantly
+    m_outlinerModel = new OutlinerModel(&m_store, this);
+    outliner = new QTreeView;
+    outliner->setModel(m_outlinerModel);
+    outliner->setHeaderHidden(true);
+    outliner->setUniformRowHeights(true);
+    connect(outliner, &QTreeView::clicked, this, &MainWindow::outlinerItemClicked);
 
     fileMenu = menuBar()->addMenu("&File");
     editMenu = menuBar()->addMenu("&Edit");
@@ -96,21 +115,27 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), m_option(ViewOpti
 
     // Edit Menu
 
-    QAction *undoButton = new QAction("&Undo", this);
+    undoButton = new QAction("&Undo", this);
+    undoButton->setShortcut(QKeySequence::Undo);
+    undoButton->setEnabled(false);
     editMenu->addAction(undoButton);
-    connect(undoButton, &QAction::triggered, this, &MainWindow::close);
+    connect(undoButton, &QAction::triggered, this, &MainWindow::undoEdit);
 
-    QAction *redoButton = new QAction("&Redo", this);
+    redoButton = new QAction("&Redo", this);
+    redoButton->setShortcut(QKeySequence::Redo);
+    redoButton->setEnabled(false);
     editMenu->addAction(redoButton);
-    connect(redoButton, &QAction::triggered, this, &MainWindow::close);
+    connect(redoButton, &QAction::triggered, this, &MainWindow::redoEdit);
 
     QAction *copyButton = new QAction("&Copy", this);
+    copyButton->setShortcut(QKeySequence::Copy);
     editMenu->addAction(copyButton);
-    connect(copyButton, &QAction::triggered, this, &MainWindow::close);
+    connect(copyButton, &QAction::triggered, this, &MainWindow::copySelection);
 
     QAction *pasteButton = new QAction("&Paste", this);
+    pasteButton->setShortcut(QKeySequence::Paste);
     editMenu->addAction(pasteButton);
-    connect(pasteButton, &QAction::triggered, this, &MainWindow::close);
+    connect(pasteButton, &QAction::triggered, this, &MainWindow::pasteBoxes);
 
     editMenu->addSeparator();
 
@@ -140,6 +165,22 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), m_option(ViewOpti
     toggleGameView->setCheckable(true);
     connect(toggleGameView, &QAction::toggled, this, &MainWindow::setGameView);
 
+    toggleProfiler = new QAction("Show &Profiler", this);
+    viewMenu->addAction(toggleProfiler);
+    toggleProfiler->setCheckable(true);
+    connect(toggleProfiler, &QAction::toggled, this, &MainWindow::setProfiler);
+
+    toggleGpu2D = new QAction("&Hardware 2D Views", this);
+    viewMenu->addAction(toggleGpu2D);
+    toggleGpu2D->setCheckable(true);
+    toggleGpu2D->setChecked(true);
+    connect(toggleGpu2D, &QAction::toggled, this, &MainWindow::setGpu2D);
+
+    toggleCompactBoxes = new QAction("&Compact GPU Boxes", this);
+    viewMenu->addAction(toggleCompactBoxes);
+    toggleCompactBoxes->setCheckable(true);
+    connect(toggleCompactBoxes, &QAction::toggled, this, &MainWindow::setCompactBoxes);
+
     // Tools Menu
 
     QAction *soundBrowser = new QAction("&Sound Browser", this);
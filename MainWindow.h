@@ -2,10 +2,12 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QClipboard>
+#include <QGuiApplication>
 #include <QFileDialog>
 #include <QListWidget>
 #include <QComboBox>
-#include <QTreeWidget>
+#include <QTreeView>
 #include <QDir>
 #include <QStringList>
 #include <QBoxLayout>
@@ -15,11 +17,14 @@
 #include <QMediaPlayer>
 #include <QAudioOutput>
 
+#include "BoxClipboard.h"
 #include "Views2D.h"
 #include "SegmentWidget.h"
 #include "SegmentLoader.h"
 #include "RoomLoader.h"
 #include "LevelLoader.h"
+#include "LoadArena.h"
+#include "OutlinerModel.h"
 #include "PreferencesDialog.h"
 
 QT_BEGIN_NAMESPACE
@@ -370,7 +375,7 @@ public:
         segmentWidget->lowerFogColour = lerpColour(lowerFogStart, lowerFogTarget, t);
         segmentWidget->upperFogColour = lerpColour(upperFogStart, upperFogTarget, t);
 
-        segmentWidget->update(); // Redraw the OpenGL widget
+        segmentWidget->requestRepaint(); // Redraw the OpenGL widget
 
         if (t >= 1.0f && fogTimer) {
             fogTimer->stop();
@@ -493,11 +498,15 @@ public:
         QString filePath = QFileDialog::getOpenFileName(this, "Open Segment XML", prefs.m_rootDir, "XML Files (*.xml)");
         if (filePath.isEmpty())
             return;
-        currentSegment = Loader::loadLevelSegment(prefs.m_rootDir, filePath, false);
-
-        populateOutliner(outliner, currentSegment);
+        closeLoadedFiles();
+        const Segment& segment = currentSegment.load([&](std::pmr::memory_resource* resource) {
+            return Loader::loadLevelSegment(prefs.m_rootDir, filePath, false, resource);
+        });
 
-        m_rects = Loader::getRects(currentSegment.boxes);
+        m_selection.clear();
+        m_store.assign(Loader::getBoxArrays(segment.boxes));
+        m_outlinerModel->setSegment(segment);
+        rectsChanged();
     }
 
     void loadRoomFromFile() {
@@ -505,25 +514,19 @@ public:
         if (filePath.isEmpty())
             return;
 
-        currentRoom = Loader::LoadRoom(filePath, prefs.m_rootDir);
-
-        startFogChange(currentRoom.lowerFog, currentRoom.upperFog);
-
-        std::vector<Box> boxes;
-
-        for (Segment& seg : currentRoom.segments) {
-            qDebug() << "Segment offset: " << seg.offset;
-            for (Box& box : seg.boxes) {
-                box.pos += QVector3D(0, 0, -seg.offset);
-                boxes.push_back(box);
-            }
-        }
+        closeLoadedFiles();
+        const Room& room = currentRoom.load([&](std::pmr::memory_resource* resource) {
+            return Loader::LoadRoom(filePath, prefs.m_rootDir, resource);
+        });
 
-        qDebug() << "Final segment offset: " << currentRoom.segments.back().offset;
+        startFogChange(room.lowerFog, room.upperFog);
 
-        populateOutliner(outliner, currentRoom);
+        BoxArrays boxes = Loader::placeRoomBoxes(room);
 
-        m_rects = Loader::getRects(boxes);
+        m_selection.clear();
+        m_store.assign(std::move(boxes));
+        m_outlinerModel->setRoom(room);
+        rectsChanged();
 
     }
 
@@ -532,30 +535,19 @@ public:
         if (filePath.isEmpty())
             return;
 
-        currentLevel = Loader::loadLevel(filePath, prefs.m_rootDir, false, false);
-
-        float totalOffset = 0.0f;
-        std::vector<Box> boxes;
-
-        for (Room& room : currentLevel.rooms) {
-            for (Segment& segment : room.segments) {
-                // Apply global room+segment offset to boxes
-                for (Box& box : segment.boxes) {
-                    box.pos += QVector3D(0, 0, -(totalOffset + segment.offset));
-                    boxes.push_back(box);
-                }
-            }
-
-            // Increase total offset by the total room length
-            if (!room.segments.empty()) {
-                Segment& lastSeg = room.segments.back();
-                totalOffset += lastSeg.offset + lastSeg.size.z();
-            }
-        }
+        closeLoadedFiles();
+        const LevelList& levels = currentLevels.load([&](std::pmr::memory_resource* resource) {
+            LevelList loaded(resource);
+            loaded.push_back(Loader::loadLevel(filePath, prefs.m_rootDir, false, false, resource));
+            return loaded;
+        });
 
-        populateOutliner(outliner, {currentLevel});
+        BoxArrays boxes = Loader::placeLevelBoxes(levels.front());
 
-        m_rects = Loader::getRects(boxes);
+        m_selection.clear();
+        m_store.assign(std::move(boxes));
+        m_outlinerModel->setLevels(levels);
+        rectsChanged();
 
     }
 
@@ -568,154 +560,53 @@ public:
 
         qDebug() << "Confirmed!";
 
-        std::vector<Level> levels = Loader::loadGame("/game.xml", prefs.m_rootDir);
-
-        float totalOffset = 0.0f;
-        std::vector<Box> boxes;
-
-        for (Level& level : levels) {
-            for (Room& room : level.rooms) {
-                for (Segment& segment : room.segments) {
-
-                    for (Box& box : segment.boxes) {
-                        // Apply cumulative offset for the entire game's room/segment structure
-                        box.pos += QVector3D(0, 0, -totalOffset);
-                        boxes.push_back(box);
-                    }
-
-                    // Increase totalOffset by segment size
-                    totalOffset += segment.size.z();
-                }
-            }
-        }
-
-        qDebug() << "Total game length:" << totalOffset;
+        closeLoadedFiles();
+        const LevelList& levels = currentLevels.load([&](std::pmr::memory_resource* resource) {
+            return Loader::loadGame("/game.xml", prefs.m_rootDir, resource);
+        });
 
-        m_rects = Loader::getRects(boxes);
+        BoxArrays boxes = Loader::placeGameBoxes(levels);
 
-        populateOutliner(outliner, levels);
+        m_selection.clear();
+        m_store.assign(std::move(boxes));
+        m_outlinerModel->setLevels(levels);
+        rectsChanged();
     }
 
     void setWireframe(bool checked) {
         segmentWidget->m_drawWireframe = checked;
+        segmentWidget->requestRepaint();
     }
 
     void setFaces(bool checked) {
         segmentWidget->m_drawFaces = checked;
+        segmentWidget->requestRepaint();
     }
 
     void setColoured(bool checked) {
         segmentWidget->m_useShader = checked;
+        segmentWidget->requestRepaint();
     }
 
     void setGameView(bool checked) {
         segmentWidget->m_gameView = checked;
+        segmentWidget->requestRepaint();
     }
 
-    void populateOutliner(QTreeWidget* treeWidget, const std::vector<Level>& levels) {
-
-        treeWidget->clear();
-
-        for (const Level& level : levels) {
-            // Add the Level item as a root
-            QTreeWidgetItem* levelItem = new QTreeWidgetItem(treeWidget);
-            levelItem->setText(0, level.name); // Set level name
-
-            // Add rooms under the Level item
-            for (const Room& room : level.rooms) {
-                QTreeWidgetItem* roomItem = new QTreeWidgetItem(levelItem);
-                roomItem->setText(0, room.name); // Set room name
-
-                // Add segments under the Room item
-                for (const Segment& segment : room.segments) {
-                    QTreeWidgetItem* segmentItem = new QTreeWidgetItem(roomItem);
-                    segmentItem->setText(0, segment.name); // Set segment name
-
-                    // Add boxes under the Segment item
-                    for (const Box& box : segment.boxes) {
-                        QTreeWidgetItem* boxItem = new QTreeWidgetItem(segmentItem);
-                        boxItem->setText(0, "Box");
-
-                        // Create a formatted string for position and size
-                        QString posText = QString("Pos: [%1, %2, %3]").arg(box.pos.x()).arg(box.pos.y()).arg(box.pos.z());
-                        QString sizeText = QString("Size: [%1, %2, %3]").arg(box.size.x()).arg(box.size.y()).arg(box.size.z());
-                        QString templateText = QString("Template: %1").arg(box.templateType);
-
-                        QTreeWidgetItem* posItem = new QTreeWidgetItem(boxItem);
-                        posItem->setText(0, posText); // Position
-
-                        QTreeWidgetItem* sizeItem = new QTreeWidgetItem(boxItem);
-                        sizeItem->setText(0, sizeText); // Size
-
-                        QTreeWidgetItem* templateItem = new QTreeWidgetItem(boxItem);
-                        templateItem->setText(0, templateText);
-                    }
-                }
-            }
-        }
+    void setGpu2D(bool checked) {
+        xyView->setGpuRendering(checked);
+        xzView->setGpuRendering(checked);
+        yzView->setGpuRendering(checked);
     }
 
-    void populateOutliner(QTreeWidget* treeWidget, const Room room) {
-
-        treeWidget->clear();
-
-        // Set room as root
-        QTreeWidgetItem* roomItem = new QTreeWidgetItem(treeWidget);
-        roomItem->setText(0, room.name); // Set level name
-
-        for (const Segment& segment : room.segments) {
-            // Add rooms under the Level item
-            QTreeWidgetItem* segmentItem = new QTreeWidgetItem(roomItem);
-            segmentItem->setText(0, segment.name); // Set segment name
-
-            // Add boxes under the Segment item
-            for (const Box& box : segment.boxes) {
-                QTreeWidgetItem* boxItem = new QTreeWidgetItem(segmentItem);
-                boxItem->setText(0, "Box");
-
-                // Create a formatted string for position and size
-                QString posText = QString("Pos: [%1, %2, %3]").arg(box.pos.x()).arg(box.pos.y()).arg(box.pos.z());
-                QString sizeText = QString("Size: [%1, %2, %3]").arg(box.size.x()).arg(box.size.y()).arg(box.size.z());
-                QString templateText = QString("Template: %1").arg(box.templateType);
-
-                QTreeWidgetItem* posItem = new QTreeWidgetItem(boxItem);
-                posItem->setText(0, posText); // Position
-
-                QTreeWidgetItem* sizeItem = new QTreeWidgetItem(boxItem);
-                sizeItem->setText(0, sizeText); // Size
-
-                QTreeWidgetItem* templateItem = new QTreeWidgetItem(boxItem);
-                templateItem->setText(0, templateText);
-            }
-        }
+    // Falls back to the float layout by itself when the scene doesn't fit the encoding
+    void setCompactBoxes(bool checked) {
+        m_sceneBuffers.setCompact(checked);
+        updateAllViews();
     }
 
-    void populateOutliner(QTreeWidget* treeWidget, const Segment& segment) {
-
-        treeWidget->clear();
-
-        // Add the Segment item as a root
-        QTreeWidgetItem* segmentItem = new QTreeWidgetItem(treeWidget);
-        segmentItem->setText(0, segment.name); // Set level name
-
-        for (const Box& box : segment.boxes) {
-            QTreeWidgetItem* boxItem = new QTreeWidgetItem(segmentItem);
-            boxItem->setText(0, "Box");
-
-            // Create a formatted string for position and size
-            QString posText = QString("Pos: [%1, %2, %3]").arg(box.pos.x()).arg(box.pos.y()).arg(box.pos.z());
-            QString sizeText = QString("Size: [%1, %2, %3]").arg(box.size.x()).arg(box.size.y()).arg(box.size.z());
-            QString templateText = QString("Template: %1").arg(box.templateType);
-
-            QTreeWidgetItem* posItem = new QTreeWidgetItem(boxItem);
-            posItem->setText(0, posText); // Position
-
-            QTreeWidgetItem* sizeItem = new QTreeWidgetItem(boxItem);
-            sizeItem->setText(0, sizeText); // Size
-
-            QTreeWidgetItem* templateItem = new QTreeWidgetItem(boxItem);
-            templateItem->setText(0, templateText);
-        }
+    void setProfiler(bool checked) {
+        segmentWidget->setShowProfiler(checked);
     }
 
     Prefs loadPrefs() {
@@ -742,19 +633,86 @@ public:
     }
 
     void update2D() {
-        xyView->update();
-        xzView->update();
-        yzView->update();
+        m_repaintScheduler->request(xyView);
+        m_repaintScheduler->request(xzView);
+        m_repaintScheduler->request(yzView);
+    }
+
+    // Selection or geometry changed, which every view shows
+    void updateAllViews() {
+        update2D();
+        segmentWidget->requestRepaint();
+    }
+
+    // Boxes were loaded, moved or deleted. The buffers and views take the changed ranges from
+    // the store on their next paint, this only asks for one.
+    void rectsChanged() {
+        m_outlinerModel->sync();
+        updateEditActions();
+        updateAllViews();
+    }
+
+    void undoEdit() {
+        if (m_history.undo()) rectsChanged();
+    }
+
+    void redoEdit() {
+        if (m_history.redo()) rectsChanged();
+    }
+
+    void copySelection() {
+        if (m_selection.isEmpty()) return;
+
+        BoxArrays boxes;
+        boxes.reserve(m_selection.items().size());
+
+        for (BoxHandle handle : m_selection.items()) {
+            int index = m_store.indexOf(handle);
+            if (index < 0) continue;
+
+            Rect3D rect = m_store.box(index);
+            boxes.append(rect.position(), rect.size(), rect.getColour(), m_store.boxes().templateType(index));
+        }
+
+        QGuiApplication::clipboard()->setMimeData(BoxClipboard::toMimeData(boxes));
+    }
+
+    // Pasted boxes land where they were copied from, as one undo step, and become the selection
+    void pasteBoxes() {
+        BoxArrays boxes = BoxClipboard::fromMimeData(QGuiApplication::clipboard()->mimeData(), prefs.m_rootDir);
+        if (boxes.isEmpty()) return;
+
+        m_selection.replace(m_history.insert(boxes));
+        rectsChanged();
+    }
+
+    void updateEditActions() {
+        undoButton->setEnabled(m_history.canUndo());
+        redoButton->setEnabled(m_history.canRedo());
+    }
+
+    // Clicking a box in the outliner selects it in every view
+    void outlinerItemClicked(const QModelIndex& index) {
+        BoxHandle handle = m_outlinerModel->handleAt(index);
+        if (handle.isNull() || !m_store.contains(handle)) return;
+
+        m_selection.replace({handle});
+        updateAllViews();
     }
 
     void openPrefs();
 
     // Menu
 
+    QAction *undoButton;
+    QAction *redoButton;
     QAction *toggleWireframeButton;
     QAction *toggleFacesButton;
     QAction *toggleColoured;
     QAction *toggleGameView;
+    QAction *toggleProfiler;
+    QAction *toggleGpu2D;
+    QAction *toggleCompactBoxes;
 
 private:
     Ui::MainWindow *ui;
@@ -765,7 +723,8 @@ private:
 
     SoundBrowser* soundBrowserDialog = nullptr;
 
-    QTreeWidget* outliner;
+    QTreeView* outliner;
+    OutlinerModel* m_outlinerModel;
 
     QMenu *fileMenu;
     QMenu *editMenu;
@@ -775,16 +734,29 @@ private:
     // Create the 3D segment widget
     SegmentWidget *segmentWidget; // 3D view widget
 
-    std::vector<Rect3D> m_rects;
-    std::vector<Rect3D*> m_selectedRects;
+    SceneStore m_store;
+    SceneBuffers m_sceneBuffers;
+    RepaintScheduler *m_repaintScheduler;
+    Selection m_selection{&m_store};
+    EditHistory m_history{&m_store, &m_selection};
 
     ViewOption m_option;
 
     void setTheme(QString theme);
 
-    Segment currentSegment;
-    Room currentRoom;
-    Level currentLevel;
+    // File data of the open asset, each in the arena its load allocated from
+    ArenaValue<Segment> currentSegment;
+    ArenaValue<Room> currentRoom;
+    ArenaValue<LevelList> currentLevels;
+
+    // Drops the previous asset's file data, one arena release per load, and the edits made to it
+    void closeLoadedFiles() {
+        m_history.clear();
+        m_outlinerModel->clear();  // It points into the file data
+        currentSegment.reset();
+        currentRoom.reset();
+        currentLevels.reset();
+    }
 
     Prefs prefs;
 
@@ -0,0 +1,89 @@
+#include "OffscreenRenderer.h"
+#include <QDebug>
+
+OffscreenRenderer::~OffscreenRenderer() {
+    if (m_context && m_surface && m_context->makeCurrent(m_surface)) {
+        m_renderer.release();
+        delete m_fbo;
+        m_context->doneCurrent();
+    }
+
+    delete m_context;
+    delete m_surface;
+}
+
+bool OffscreenRenderer::create(const QSize& size, const QString& rootDir) {
+    m_size = size;
+
+    // The renderer still uses fixed function calls for outlines, so ask for a compatibility context
+    QSurfaceFormat format;
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CompatibilityProfile);
+    format.setDepthBufferSize(24);
+
+    m_surface = new QOffscreenSurface();
+    m_surface->setFormat(format);
+    m_surface->create();
+
+    if (!m_surface->isValid()) {
+        qWarning() << "Failed to create offscreen surface";
+        return false;
+    }
+
+    m_context = new QOpenGLContext();
+    m_context->setFormat(format);
+
+    if (!m_context->create()) {
+        qWarning() << "Failed to create OpenGL context";
+        return false;
+    }
+
+    if (!m_context->makeCurrent(m_surface)) {
+        qWarning() << "Failed to make OpenGL context current";
+        return false;
+    }
+
+    QOpenGLFramebufferObjectFormat fboFormat;
+    fboFormat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+
+    m_fbo = new QOpenGLFramebufferObject(m_size, fboFormat);
+
+    if (!m_fbo->isValid()) {
+        qWarning() << "Failed to create framebuffer object of size" << m_size;
+        return false;
+    }
+
+    m_fbo->bind();
+
+    m_renderer.initialize(rootDir);
+    m_renderer.resize(m_size.width(), m_size.height());
+    m_renderer.profiler().setEnabled(true);
+
+    m_glRenderer = QString::fromLatin1(reinterpret_cast<const char*>(m_context->functions()->glGetString(GL_RENDERER)));
+    qDebug() << "Offscreen renderer:" << m_glRenderer;
+
+    return true;
+}
+
+void OffscreenRenderer::renderFrame(const SceneStore& store, const Selection& selection,
+                                    const RenderCamera& camera, const RenderOptions& options) {
+    m_context->makeCurrent(m_surface);
+    m_fbo->bind();
+
+    FrameProfiler& profiler = m_renderer.profiler();
+
+    profiler.beginFrame();
+    m_renderer.render(store, selection, camera, options);
+    m_renderer.endScene();
+    profiler.endFrame();
+
+    m_context->functions()->glFinish();
+    profiler.finish();
+
+    m_lastFrame = profiler.lastFrame();
+}
+
+QImage OffscreenRenderer::grabImage() {
+    m_context->makeCurrent(m_surface);
+    return m_fbo->toImage();
+}
@@ -0,0 +1,45 @@
+#ifndef OFFSCREENRENDERER_H
+#define OFFSCREENRENDERER_H
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QImage>
+#include "SegmentRenderer.h"
+
+// Runs SegmentRenderer without a window, on a QOffscreenSurface rendering into an FBO.
+// Works with Mesa's software GL (QT_QPA_PLATFORM=offscreen LIBGL_ALWAYS_SOFTWARE=1).
+class OffscreenRenderer {
+public:
+    OffscreenRenderer() = default;
+    ~OffscreenRenderer();
+
+    bool create(const QSize& size, const QString& rootDir);
+
+    // Renders one frame and waits for the GPU so the profiler stats are final
+    void renderFrame(const SceneStore& store, const Selection& selection,
+                     const RenderCamera& camera, const RenderOptions& options);
+
+    QImage grabImage();
+
+    SegmentRenderer& renderer() { return m_renderer; }
+    const FrameProfiler::FrameStats& lastFrame() const { return m_lastFrame; }
+
+    QSize size() const { return m_size; }
+
+    // GL_RENDERER of the context, recorded with benchmark results
+    QString glRendererName() const { return m_glRenderer; }
+
+private:
+    QOffscreenSurface *m_surface = nullptr;
+    QOpenGLContext *m_context = nullptr;
+    QOpenGLFramebufferObject *m_fbo = nullptr;
+
+    SegmentRenderer m_renderer;
+    FrameProfiler::FrameStats m_lastFrame;
+
+    QSize m_size;
+    QString m_glRenderer;
+};
+
+#endif // OFFSCREENRENDERER_H
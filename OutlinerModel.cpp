@@ -0,0 +1,279 @@
+#include "OutlinerModel.h"
+#include <iterator>
+
+OutlinerModel::OutlinerModel(SceneStore *store, QObject *parent) : QAbstractItemModel(parent), m_store(store) {
+    m_changes.attach(store);
+}
+
+void OutlinerModel::setLevels(const LevelList& levels) {
+    reset(GameNode, &levels);
+}
+
+void OutlinerModel::setRoom(const Room& room) {
+    reset(RoomNode, &room);
+}
+
+void OutlinerModel::setSegment(const Segment& segment) {
+    reset(SegmentNode, &segment);
+}
+
+void OutlinerModel::clear() {
+    beginResetModel();
+    m_nodes.clear();
+    m_segmentOfBox.clear();
+    m_changes.clear();
+    endResetModel();
+}
+
+void OutlinerModel::reset(Kind kind, const void *data) {
+    beginResetModel();
+    m_nodes.clear();
+    m_segmentOfBox.clear();
+
+    // Only the hidden root, everything under it is made when the view asks
+    m_nodes.push_back({kind, data, -1, 0, 0});
+
+    // The assign() this follows is already in the tree
+    m_changes.clear();
+    endResetModel();
+}
+
+BoxHandle OutlinerModel::handleAt(const QModelIndex& index) const {
+    if (!index.isValid() || tagOf(index) != BoxTag) return BoxHandle();
+    return m_store->assignedHandle(numberOf(index));
+}
+
+void OutlinerModel::sync() {
+    // Loads set the tree again themselves
+    if (m_changes.isReset() || m_nodes.empty()) {
+        m_changes.clear();
+        return;
+    }
+
+    auto refresh = [this](BoxHandle handle) {
+        int box = m_store->assignedIndex(handle);
+        if (box < 0) return;  // Pasted, the file doesn't have it
+
+        // Boxes of segments never expanded have no rows yet, they read the store once they do
+        int segment = segmentOf(box);
+        if (segment < 0) return;
+
+        QModelIndex boxRow = boxIndex(box, segment);
+        emit dataChanged(boxRow, boxRow);
+        emit dataChanged(index(0, 0, boxRow), index(kDetailRows - 1, 0, boxRow));
+    };
+
+    for (BoxHandle handle : m_changes.removedHandles()) refresh(handle);
+
+    const quint32 shown = SceneChange::Position | SceneChange::Size | SceneChange::Template;
+    for (const SceneChangeSet::Range& range : m_changes.ranges()) {
+        // Selecting a box doesn't change its text
+        if (!(range.fields & shown)) continue;
+
+        for (size_t i = range.first; i < range.last; ++i) refresh(m_store->handleAt(i));
+    }
+
+    m_changes.clear();
+}
+
+QModelIndex OutlinerModel::index(int row, int column, const QModelIndex& parent) const {
+    if (column != 0 || row < 0 || row >= rowCount(parent)) return QModelIndex();
+
+    if (!parent.isValid()) return createIndex(row, 0, makeId(NodeTag, children(0) + row));
+
+    switch (tagOf(parent)) {
+    case NodeTag: {
+        int node = static_cast<int>(numberOf(parent));
+        if (m_nodes[node].kind != SegmentNode) return createIndex(row, 0, makeId(NodeTag, children(node) + row));
+
+        // Box rows are numbers, the segment only has to be findable from them
+        m_segmentOfBox.emplace(m_nodes[node].firstBox, node);
+        return createIndex(row, 0, makeId(BoxTag, m_nodes[node].firstBox + row));
+    }
+
+    case BoxTag:
+        return createIndex(row, 0, makeId(DetailTag, numberOf(parent)));
+
+    default:
+        return QModelIndex();
+    }
+}
+
+QModelIndex OutlinerModel::parent(const QModelIndex& child) const {
+    if (!child.isValid()) return QModelIndex();
+
+    switch (tagOf(child)) {
+    case NodeTag: {
+        int owner = m_nodes[numberOf(child)].parent;
+        if (owner <= 0) return QModelIndex();  // Top level rows hang off the hidden root
+        return createIndex(m_nodes[owner].row, 0, makeId(NodeTag, owner));
+    }
+
+    case BoxTag: {
+        int segment = segmentOf(numberOf(child));
+        if (segment < 0) return QModelIndex();
+        return createIndex(m_nodes[segment].row, 0, makeId(NodeTag, segment));
+    }
+
+    case DetailTag: {
+        size_t box = numberOf(child);
+        int segment = segmentOf(box);
+        if (segment < 0) return QModelIndex();
+        return boxIndex(box, segment);
+    }
+    }
+
+    return QModelIndex();
+}
+
+int OutlinerModel::rowCount(const QModelIndex& parent) const {
+    if (m_nodes.empty() || parent.column() > 0) return 0;
+    if (!parent.isValid()) return childCount(0);
+
+    switch (tagOf(parent)) {
+    case NodeTag:
+        return childCount(static_cast<int>(numberOf(parent)));
+    case BoxTag:
+        return kDetailRows;
+    default:
+        return 0;
+    }
+}
+
+int OutlinerModel::columnCount(const QModelIndex&) const {
+    return 1;
+}
+
+QVariant OutlinerModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || role != Qt::DisplayRole) return QVariant();
+
+    switch (tagOf(index)) {
+    case NodeTag: {
+        const Node& node = m_nodes[numberOf(index)];
+        switch (node.kind) {
+        case LevelNode:
+            return static_cast<const Level*>(node.data)->name;
+        case RoomNode:
+            return static_cast<const Room*>(node.data)->name;
+        case SegmentNode:
+            return static_cast<const Segment*>(node.data)->name;
+        default:
+            return QVariant();
+        }
+    }
+
+    case BoxTag:
+        // Deleted boxes keep their row, greyed out, so undo can bring them back in place
+        return m_store->contains(m_store->assignedHandle(numberOf(index))) ? QString("Box") : QString("Box (deleted)");
+
+    case DetailTag: {
+        int box = m_store->indexOf(m_store->assignedHandle(numberOf(index)));
+        if (box < 0) return QVariant();
+
+        // Placed position, with the segment offset the file position doesn't have
+        const BoxArrays& boxes = m_store->boxes();
+        if (index.row() == 0) {
+            QVector3D pos = boxes.position(box);
+            return QString("Pos: [%1, %2, %3]").arg(pos.x()).arg(pos.y()).arg(pos.z());
+        }
+        if (index.row() == 1) {
+            QVector3D size = boxes.halfSize(box);
+            return QString("Size: [%1, %2, %3]").arg(size.x()).arg(size.y()).arg(size.z());
+        }
+        return QString("Template: %1").arg(boxes.templateType(box).toString());
+    }
+    }
+
+    return QVariant();
+}
+
+Qt::ItemFlags OutlinerModel::flags(const QModelIndex& index) const {
+    if (!index.isValid()) return Qt::NoItemFlags;
+    if (tagOf(index) == NodeTag) return QAbstractItemModel::flags(index);
+
+    bool live = m_store->contains(m_store->assignedHandle(numberOf(index)));
+    return live ? QAbstractItemModel::flags(index) : Qt::NoItemFlags;
+}
+
+int OutlinerModel::childCount(int node) const {
+    const Node& n = m_nodes[node];
+
+    // The root stands for the loaded asset, a room or segment is its only top level row
+    if (node == 0 && n.kind != GameNode) return 1;
+
+    switch (n.kind) {
+    case GameNode:
+        return static_cast<int>(static_cast<const LevelList*>(n.data)->size());
+    case LevelNode:
+        return static_cast<int>(static_cast<const Level*>(n.data)->rooms.size());
+    case RoomNode:
+        return static_cast<int>(static_cast<const Room*>(n.data)->segments.size());
+    case SegmentNode:
+        return static_cast<int>(static_cast<const Segment*>(n.data)->boxes.size());
+    }
+    return 0;
+}
+
+int OutlinerModel::children(int node) const {
+    if (m_nodes[node].firstChild >= 0) return m_nodes[node].firstChild;
+
+    // A copy, adding the children can move m_nodes
+    const Node owner = m_nodes[node];
+    const int first = static_cast<int>(m_nodes.size());
+    size_t box = owner.firstBox;
+
+    auto add = [&](Kind kind, const void *data, int row) {
+        m_nodes.push_back({kind, data, node, row, box});
+        box += boxCount(kind, data);
+    };
+
+    if (node == 0 && owner.kind != GameNode) {
+        add(owner.kind, owner.data, 0);
+    } else if (owner.kind == GameNode) {
+        const LevelList& levels = *static_cast<const LevelList*>(owner.data);
+        for (size_t i = 0; i < levels.size(); ++i) add(LevelNode, &levels[i], static_cast<int>(i));
+    } else if (owner.kind == LevelNode) {
+        const auto& rooms = static_cast<const Level*>(owner.data)->rooms;
+        for (size_t i = 0; i < rooms.size(); ++i) add(RoomNode, &rooms[i], static_cast<int>(i));
+    } else if (owner.kind == RoomNode) {
+        const auto& segments = static_cast<const Room*>(owner.data)->segments;
+        for (size_t i = 0; i < segments.size(); ++i) add(SegmentNode, &segments[i], static_cast<int>(i));
+    }
+
+    m_nodes[node].firstChild = first;
+    return first;
+}
+
+int OutlinerModel::segmentOf(size_t box) const {
+    auto it = m_segmentOfBox.upper_bound(box);
+    if (it == m_segmentOfBox.begin()) return -1;
+
+    int segment = std::prev(it)->second;
+    const Node& node = m_nodes[segment];
+    return box < node.firstBox + boxCount(SegmentNode, node.data) ? segment : -1;
+}
+
+size_t OutlinerModel::boxCount(Kind kind, const void *data) {
+    size_t count = 0;
+
+    switch (kind) {
+    case GameNode:
+        for (const Level& level : *static_cast<const LevelList*>(data)) count += boxCount(LevelNode, &level);
+        break;
+    case LevelNode:
+        for (const Room& room : static_cast<const Level*>(data)->rooms) count += boxCount(RoomNode, &room);
+        break;
+    case RoomNode:
+        for (const Segment& segment : static_cast<const Room*>(data)->segments) count += segment.boxes.size();
+        break;
+    case SegmentNode:
+        count = static_cast<const Segment*>(data)->boxes.size();
+        break;
+    }
+
+    return count;
+}
+
+QModelIndex OutlinerModel::boxIndex(size_t box, int segment) const {
+    return createIndex(static_cast<int>(box - m_nodes[segment].firstBox), 0, makeId(BoxTag, box));
+}
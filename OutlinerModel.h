@@ -0,0 +1,79 @@
+#ifndef OUTLINERMODEL_H
+#define OUTLINERMODEL_H
+
+#include <QAbstractItemModel>
+#include <map>
+#include <vector>
+#include "LevelLoader.h"
+#include "SceneChangeSet.h"
+
+// Level, room, segment and box tree of the open asset for a QTreeView. Nothing is built up front:
+// a level's rooms or a room's segments get their nodes the first time the view asks for them,
+// boxes and their Pos, Size and Template rows are addressed by box number and never get one,
+// and text is only formatted for rows being painted. Box rows read the store, so they follow edits.
+// The tree points into the loaded file data, set() it again or clear() it before that goes away.
+class OutlinerModel : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    explicit OutlinerModel(SceneStore *store, QObject *parent = nullptr);
+
+    // The loaders place boxes in the order the tree walks them, call these right after the
+    // store's assign() so the nth box in the tree is assignedHandle(n)
+    void setLevels(const LevelList& levels);
+    void setRoom(const Room& room);
+    void setSegment(const Segment& segment);
+    void clear();
+
+    // Null for anything but a box row
+    BoxHandle handleAt(const QModelIndex& index) const;
+
+    // Repaints the rows of boxes edited, removed or restored since the last call
+    void sync();
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+
+private:
+    enum Kind { GameNode, LevelNode, RoomNode, SegmentNode };
+
+    // What internalId() means, in its low two bits
+    enum Tag { NodeTag, BoxTag, DetailTag };
+
+    static constexpr int kDetailRows = 3;  // Pos, Size, Template
+
+    struct Node {
+        Kind kind;
+        const void *data;     // The LevelList, Level, Room or Segment
+        int parent;           // -1 for the root, which the view doesn't show
+        int row;
+        size_t firstBox;      // Number of the first box under this node
+        int firstChild = -1;  // Children sit next to each other from here, -1 until asked for
+    };
+
+    SceneStore *m_store;
+    SceneChangeSet m_changes;
+
+    mutable std::vector<Node> m_nodes;
+    mutable std::map<size_t, int> m_segmentOfBox;  // First box number to node, for segments with boxes shown
+
+    void reset(Kind kind, const void *data);
+
+    int childCount(int node) const;
+    int children(int node) const;
+    int segmentOf(size_t box) const;
+
+    static size_t boxCount(Kind kind, const void *data);
+
+    static quintptr makeId(Tag tag, size_t number) { return (static_cast<quintptr>(number) << 2) | tag; }
+    static Tag tagOf(const QModelIndex& index) { return Tag(index.internalId() & 3); }
+    static size_t numberOf(const QModelIndex& index) { return index.internalId() >> 2; }
+
+    QModelIndex boxIndex(size_t box, int segment) const;
+};
+
+#endif // OUTLINERMODEL_H
@@ -0,0 +1,45 @@
+#include "RepaintScheduler.h"
+#include <QGuiApplication>
+#include <QScreen>
+#include <algorithm>
+
+RepaintScheduler::RepaintScheduler(QObject *parent) : QObject(parent) {
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &RepaintScheduler::flush);
+}
+
+int RepaintScheduler::frameInterval() const {
+    QScreen *screen = QGuiApplication::primaryScreen();
+    qreal rate = screen ? screen->refreshRate() : 60.0;
+    return std::max(1, static_cast<int>(1000.0 / std::max<qreal>(rate, 1.0)));
+}
+
+void RepaintScheduler::request(QWidget *view) {
+    if (!view) return;
+
+    if (std::find(m_pending.begin(), m_pending.end(), view) == m_pending.end()) {
+        m_pending.emplace_back(view);
+    }
+
+    if (m_timer.isActive()) return;
+
+    // Flush straight away after an idle period, otherwise wait out the rest of the frame
+    int wait = 0;
+    if (m_sinceFlush.isValid()) {
+        wait = std::max<qint64>(0, frameInterval() - m_sinceFlush.elapsed());
+    }
+
+    m_timer.start(wait);
+}
+
+void RepaintScheduler::flush() {
+    m_sinceFlush.start();
+
+    std::vector<QPointer<QWidget>> views;
+    views.swap(m_pending);
+
+    for (const QPointer<QWidget>& view : views) {
+        if (view) view->update();
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef REPAINTSCHEDULER_H
+#define REPAINTSCHEDULER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QWidget>
+#include <vector>
+
+// Collects repaint requests from all four views and flushes them together, at most once per
+// display refresh. A view asked for several times before the flush is repainted once.
+class RepaintScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    explicit RepaintScheduler(QObject *parent = nullptr);
+
+    void request(QWidget *view);
+
+private:
+    std::vector<QPointer<QWidget>> m_pending;
+    QTimer m_timer;
+    QElapsedTimer m_sinceFlush;
+
+    int frameInterval() const;
+    void flush();
+};
+
+#endif // REPAINTSCHEDULER_H
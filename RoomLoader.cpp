@@ -1,6 +1,7 @@
 #include "RoomLoader.h"
 #include <QFileInfo>
 #include <QPair>
+#include <optional>
 #include <regex>
 
 QString extractFileName(const QString& roomPath) {
@@ -14,8 +15,9 @@ QString extractFileName(const QString& roomPath) {
 }
 
 // Function to load room file via QFileDialog
-Room Loader::LoadRoom(const QString& roomPath, const QString& rootDir) {
-    Room room;
+Room Loader::LoadRoom(const QString& roomPath, const QString& rootDir, std::pmr::memory_resource* resource,
+                      const TemplateTable* templates) {
+    Room room(resource);
     room.name = extractFileName(roomPath);
 
     // Open the Lua file using QFileDialog
@@ -30,7 +32,7 @@ Room Loader::LoadRoom(const QString& roomPath, const QString& rootDir) {
     QString luaContent = in.readAll();
 
     // Parse the Lua content into Room data structure
-    ParseLuaFile(luaContent, room, rootDir);
+    ParseLuaFile(luaContent, room, rootDir, templates);
 
     return room;
 }
@@ -73,10 +75,17 @@ std::vector<float> extractFogColors(const std::string& luaLine) {
 }
 
 // Adds the segments to the room
-void Loader::ParseLuaFile(const QString& luaContent, Room& room, const QString& rootDir) {
-    std::vector<Segment> tempSegments;  // Temporary storage for segments
-    Segment startSegment;  // For start.xml
-    Segment doorSegment;   // For door.xml
+void Loader::ParseLuaFile(const QString& luaContent, Room& room, const QString& rootDir, const TemplateTable* templates) {
+    std::pmr::memory_resource* resource = room.segments.get_allocator().resource();
+
+    std::optional<TemplateTable> ownTemplates;
+    if (!templates) templates = &ownTemplates.emplace(rootDir);
+
+    // Middle segments are read straight into the room behind a slot for the start segment,
+    // so each one is moved at most by the vector growing, never copied
+    room.segments.clear();
+    room.segments.emplace_back(resource);  // For start.xml
+    Segment doorSegment(resource);         // For door.xml
 
     // Split luaContent into lines
     std::istringstream stream(luaContent.toStdString());
@@ -89,16 +98,15 @@ void Loader::ParseLuaFile(const QString& luaContent, Room& room, const QString&
             bool canLoad = true;
 
             if (segmentPath.size() >= 5 && segmentPath.substr(segmentPath.size() - 5) == "start") {
-                startSegment = loadLevelSegment(rootDir, QString::fromStdString("/segments/" + segmentPath + ".xml"), true);
+                room.segments.front() = loadLevelSegment(rootDir, QString::fromStdString("/segments/" + segmentPath + ".xml"), true, resource, templates);
                 canLoad = false;
             }
             else if (segmentPath.size() >= 4 && segmentPath.substr(segmentPath.size() - 4) == "door") {
-                doorSegment = loadLevelSegment(rootDir, QString::fromStdString("/segments/" + segmentPath + ".xml"), true);
+                doorSegment = loadLevelSegment(rootDir, QString::fromStdString("/segments/" + segmentPath + ".xml"), true, resource, templates);
                 canLoad = false;
             }
             else if (canLoad && !segmentPath.empty()) {
-                Segment newSegment = loadLevelSegment(rootDir, QString::fromStdString("/segments/" + segmentPath + ".xml"), true);
-                tempSegments.push_back(newSegment);
+                room.segments.push_back(loadLevelSegment(rootDir, QString::fromStdString("/segments/" + segmentPath + ".xml"), true, resource, templates));
             }
         }
         if (line.find("mgFogColor") != std::string::npos) {
@@ -110,32 +118,14 @@ void Loader::ParseLuaFile(const QString& luaContent, Room& room, const QString&
         }
     }
 
-    float currentOffset = 0.0f;
-
-    // Add start segment first
-    startSegment.offset = currentOffset;
-    //qDebug() << "Start segment is" << startSegment.name;
-    room.segments.push_back(startSegment);
-    currentOffset += startSegment.size.z();
+    // Add door segment last, moved, a copy would leave the arena for the default heap
+    room.segments.push_back(std::move(doorSegment));
 
-    // Add all middle segments
-    for (Segment& seg : tempSegments) {
+    // Start, middle and door segments follow each other along z
+    float currentOffset = 0.0f;
+    for (Segment& seg : room.segments) {
         seg.offset = currentOffset;
-        //qDebug() << "Segment:" << seg.name << "has offset:" << seg.offset;
-        room.segments.push_back(seg);
         currentOffset += seg.size.z();
-        //qDebug() << currentOffset;
-
-    }
-
-    // Add door segment last
-    doorSegment.offset = currentOffset;
-    //qDebug() << "Door Segment Offset" << doorSegment.offset;
-    room.segments.push_back(doorSegment);
-
-    //qDebug() << "Final checking!";
-
-    for (Segment& seg : room.segments) {
         qDebug() << "Segment:" << seg.name << "has offset:" << seg.offset;
     }
 }
@@ -6,9 +6,17 @@
 #include "SegmentLoader.h"
 
 struct Room {
+    explicit Room(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : segments(resource) {}
+
+    Room(Room&&) = default;
+    Room& operator=(Room&&) = default;
+    Room(const Room&) = delete;
+    Room& operator=(const Room&) = delete;
+
     bool pStart = true;  // Whether the room starts with a start segment.
     bool pEnd = true;    // Whether the room ends with a door segment.
-    std::vector<Segment> segments;  // List of possible segments.
+    std::pmr::vector<Segment> segments;  // List of possible segments.
     QString name;
     std::array<float, 4> lowerFog;
     std::array<float, 4> upperFog;
@@ -17,10 +25,13 @@ struct Room {
 QString extractFileName(const QString& roomPath);
 
 namespace Loader {
-    Room LoadRoom(const QString& roomPath, const QString& rootDir);
+    // Without templates, the room reads rootDir's table once for all its segments
+    Room LoadRoom(const QString& roomPath, const QString& rootDir,
+                  std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                  const TemplateTable* templates = nullptr);
 
-    // Function to parse the Lua script to extract segments
-    void ParseLuaFile(const QString& luaContent, Room& room, const QString& rootDir);
+    // Function to parse the Lua script to extract segments, allocated from the room's resource
+    void ParseLuaFile(const QString& luaContent, Room& room, const QString& rootDir, const TemplateTable* templates = nullptr);
 }
 
 #endif // ROOMLOADER_H
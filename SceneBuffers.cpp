@@ -0,0 +1,428 @@
+#include "SceneBuffers.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+static_assert(sizeof(SceneBuffers::CompactBox) == 16, "CompactBox must stay tightly packed");
+
+namespace {
+
+// Templates with a colour texel, more fall back to the float planes. Also capped by GL_MAX_TEXTURE_SIZE.
+constexpr size_t kMaxTemplates = 4096;
+
+bool quantize(float value, qint16& out) {
+    float steps = std::round(value / SceneBuffers::kCompactStep);
+    if (!(steps >= -32768.0f && steps <= 32767.0f)) return false;
+    out = static_cast<qint16>(steps);
+    return true;
+}
+
+bool quantize(float value, quint16& out) {
+    float steps = std::round(value / SceneBuffers::kCompactStep);
+    if (!(steps >= 0.0f && steps <= 65535.0f)) return false;
+    out = static_cast<quint16>(steps);
+    return true;
+}
+
+// The kOriginSpan band around z, false for z too far out to number its band
+bool bandOf(float z, qint32& band) {
+    float nearest = std::round(z / SceneBuffers::kOriginSpan);
+    if (!(std::fabs(nearest) < 1.0e6f)) return false;
+    band = static_cast<qint32>(nearest);
+    return true;
+}
+
+bool encodeBox(const BoxArrays& boxes, size_t index, qint32 band, quint16 origin, SceneBuffers::CompactBox& out) {
+    quint32 templateId = boxes.templateType(index).id();
+    if (templateId >= 0x8000) return false;
+
+    out.style = static_cast<quint16>(templateId * 2 + (boxes.isSelected(index) ? 1 : 0));
+    out.origin = origin;
+
+    float z = boxes.plane(BoxArrays::Z)[index] - band * SceneBuffers::kOriginSpan;
+
+    return quantize(boxes.plane(BoxArrays::X)[index], out.x)
+        && quantize(boxes.plane(BoxArrays::Y)[index], out.y)
+        && quantize(z, out.z)
+        && quantize(boxes.plane(BoxArrays::Width)[index], out.halfX)
+        && quantize(boxes.plane(BoxArrays::Height)[index], out.halfY)
+        && quantize(boxes.plane(BoxArrays::Depth)[index], out.halfZ);
+}
+
+// Encodes every box, collects one RGB colour per template id and one origin per z band in use.
+// Fails if a box doesn't fit, if either table would outgrow maxTexels, or if two boxes of one
+// template differ in colour, since the shader looks colour up by template.
+bool encodeCompact(const BoxArrays& boxes, size_t maxTexels, std::vector<SceneBuffers::CompactBox>& encoded,
+                   std::vector<GLfloat>& colours, std::vector<GLfloat>& originTable, std::unordered_map<qint32, quint16>& origins) {
+    const float* red = boxes.plane(BoxArrays::Red);
+    const float* green = boxes.plane(BoxArrays::Green);
+    const float* blue = boxes.plane(BoxArrays::Blue);
+
+    encoded.resize(boxes.size());
+    colours.assign(3, 1.0f);
+    originTable.clear();
+    origins.clear();
+    std::vector<bool> seen(1, false);
+
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        qint32 band = 0;
+        if (!bandOf(boxes.plane(BoxArrays::Z)[i], band)) return false;
+
+        auto origin = origins.find(band);
+        if (origin == origins.end()) {
+            if (originTable.size() >= maxTexels) return false;
+            origin = origins.emplace(band, static_cast<quint16>(originTable.size())).first;
+            originTable.push_back(band * SceneBuffers::kOriginSpan);
+        }
+
+        if (!encodeBox(boxes, i, band, origin->second, encoded[i])) return false;
+
+        size_t id = boxes.templateType(i).id();
+        if (id >= seen.size()) {
+            if (id >= maxTexels) return false;
+            seen.resize(id + 1, false);
+            colours.resize(3 * (id + 1), 1.0f);
+        }
+
+        GLfloat* colour = &colours[3 * id];
+        if (!seen[id]) {
+            colour[0] = red[i];
+            colour[1] = green[i];
+            colour[2] = blue[i];
+            seen[id] = true;
+        } else if (colour[0] != red[i] || colour[1] != green[i] || colour[2] != blue[i]) {
+            return false;
+        }
+    }
+
+    // An empty scene still binds a valid texture
+    if (originTable.empty()) originTable.push_back(0.0f);
+    return true;
+}
+
+// One row of texels, sampled exactly so filtering never mixes neighbours
+void uploadTable(QOpenGLFunctions_3_3_Core *gl, GLuint& texture, GLint internalFormat, GLenum format, GLsizei width, const GLfloat* data) {
+    GLint previous = 0;
+    gl->glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+
+    if (!texture) gl->glGenTextures(1, &texture);
+    gl->glBindTexture(GL_TEXTURE_2D, texture);
+    gl->glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, 1, 0, format, GL_FLOAT, data);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl->glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previous));
+}
+
+}
+
+SceneBuffers::InstanceAttributes SceneBuffers::locate(QOpenGLShaderProgram *program) {
+    static const char* names[BoxArrays::PlaneCount] = {
+        "aCenterX", "aCenterY", "aCenterZ",
+        "aHalfX", "aHalfY", "aHalfZ",
+        "aRed", "aGreen", "aBlue",
+        "aSelected"
+    };
+
+    static const char* compactNames[CompactAttributeCount] = {
+        "aCompactXYZ", "aCompactHalf", "aCompactStyle", "aCompactOrigin"
+    };
+
+    InstanceAttributes attributes;
+    for (int p = 0; p < BoxArrays::PlaneCount; ++p) {
+        attributes.planes[p] = program->attributeLocation(names[p]);
+    }
+    for (int a = 0; a < CompactAttributeCount; ++a) {
+        attributes.compact[a] = program->attributeLocation(compactNames[a]);
+    }
+    return attributes;
+}
+
+void SceneBuffers::createStaticBuffers(QOpenGLFunctions_3_3_Core *gl) {
+    const GLfloat p[8][3] = {
+        {-1, -1, -1}, { 1, -1, -1}, { 1,  1, -1}, {-1,  1, -1},
+        {-1, -1,  1}, { 1, -1,  1}, { 1,  1,  1}, {-1,  1,  1}
+    };
+
+    // Two triangles per face, wound counter-clockwise seen from outside
+    const int faces[6][4] = {
+        {0, 1, 2, 3},  // Front  - Z-
+        {5, 4, 7, 6},  // Back   - Z+
+        {4, 0, 3, 7},  // Left   - X-
+        {1, 5, 6, 2},  // Right  - X+
+        {3, 2, 6, 7},  // Top    - Y+
+        {0, 4, 5, 1}   // Bottom - Y-
+    };
+
+    const GLfloat uv[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+    const int triangles[6] = {0, 1, 2, 0, 2, 3};
+
+    std::vector<GLfloat> cube;
+    cube.reserve(36 * 5);
+
+    for (const auto& face : faces) {
+        for (int corner : triangles) {
+            const GLfloat* vertex = p[face[corner]];
+            cube.insert(cube.end(), {vertex[0], vertex[1], vertex[2], uv[corner][0], uv[corner][1]});
+        }
+    }
+
+    const GLfloat outline[] = {
+        -1, -1, 0,   1, -1, 0,
+         1, -1, 0,   1,  1, 0,
+         1,  1, 0,  -1,  1, 0,
+        -1,  1, 0,  -1, -1, 0,
+
+        -1, -1, 1,   1,  1, 1,
+        -1,  1, 1,   1, -1, 1
+    };
+
+    gl->glGenBuffers(1, &m_cubeBuffer);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, m_cubeBuffer);
+    gl->glBufferData(GL_ARRAY_BUFFER, cube.size() * sizeof(GLfloat), cube.data(), GL_STATIC_DRAW);
+
+    gl->glGenBuffers(1, &m_outlineBuffer);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, m_outlineBuffer);
+    gl->glBufferData(GL_ARRAY_BUFFER, sizeof(outline), outline, GL_STATIC_DRAW);
+
+    gl->glGenBuffers(1, &m_instanceBuffer);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool SceneBuffers::uploadCompactRange(QOpenGLFunctions_3_3_Core *gl, const BoxArrays& boxes, size_t first, size_t last,
+                                      bool checkColours) {
+    std::vector<CompactBox> encoded(last - first);
+
+    for (size_t i = first; i < last; ++i) {
+        // Moved into a band the origin table doesn't have
+        qint32 band = 0;
+        if (!bandOf(boxes.plane(BoxArrays::Z)[i], band)) return false;
+
+        auto origin = m_origins.find(band);
+        if (origin == m_origins.end()) return false;
+
+        if (!encodeBox(boxes, i, band, origin->second, encoded[i - first])) return false;
+        if (!checkColours) continue;
+
+        // A template the texture has no texel for, or a colour other than the texel's
+        size_t id = boxes.templateType(i).id();
+        if (id >= static_cast<size_t>(m_templateCount)) return false;
+
+        const GLfloat* colour = &m_templateColours[3 * id];
+        if (colour[0] != boxes.plane(BoxArrays::Red)[i] || colour[1] != boxes.plane(BoxArrays::Green)[i] ||
+            colour[2] != boxes.plane(BoxArrays::Blue)[i]) {
+            return false;
+        }
+    }
+
+    gl->glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(first * sizeof(CompactBox)),
+                        encoded.size() * sizeof(CompactBox), encoded.data());
+    return true;
+}
+
+void SceneBuffers::setCompact(bool compact) {
+    if (compact == m_compactRequested) return;
+    m_compactRequested = compact;
+    m_dirty = true;
+}
+
+void SceneBuffers::sync(QOpenGLFunctions_3_3_Core *gl, const SceneStore& store) {
+    if (!m_instanceBuffer) createStaticBuffers(gl);
+
+    gl->glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+
+    bool full = m_dirty;
+    if (m_changes.isAttached()) full = full || m_changes.isReset() || !uploadChanges(gl, store);
+    else full = full || m_uploadedLayout != store.layoutRevision();
+
+    if (full) uploadAll(gl, store);
+
+    m_changes.clear();
+    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool SceneBuffers::uploadChanges(QOpenGLFunctions_3_3_Core *gl, const SceneStore& store) {
+    const BoxArrays& boxes = store.boxes();
+
+    if (m_changes.isEmpty() && boxes.size() == m_uploadedCount) return true;
+
+    // Grown past the buffer, or so much changed that many small uploads would cost more than one
+    if (boxes.size() > m_capacity || m_changes.dirtyCount() > boxes.size() / 2) return false;
+
+    // Which planes each field lives in, template ids only reach the GPU in the compact layout
+    static const std::pair<quint32, std::vector<BoxArrays::Plane>> fieldPlanes[] = {
+        {SceneChange::Position, {BoxArrays::X, BoxArrays::Y, BoxArrays::Z}},
+        {SceneChange::Size, {BoxArrays::Width, BoxArrays::Height, BoxArrays::Depth}},
+        {SceneChange::Colour, {BoxArrays::Red, BoxArrays::Green, BoxArrays::Blue}},
+        {SceneChange::Selected, {BoxArrays::Selected}}
+    };
+
+    for (const SceneChangeSet::Range& range : m_changes.ranges()) {
+        if (m_compactUploaded) {
+            bool checkColours = range.fields & (SceneChange::Colour | SceneChange::Template);
+            if (!uploadCompactRange(gl, boxes, range.first, range.last, checkColours)) return false;
+            continue;
+        }
+
+        size_t count = range.last - range.first;
+        for (const auto& [field, planes] : fieldPlanes) {
+            if (!(range.fields & field)) continue;
+
+            for (BoxArrays::Plane plane : planes) {
+                gl->glBufferSubData(GL_ARRAY_BUFFER, planeOffset(plane) + range.first * sizeof(float), count * sizeof(float),
+                                    boxes.plane(plane) + range.first);
+            }
+        }
+    }
+
+    // Removed boxes past the new end just stop being drawn
+    m_uploadedCount = boxes.size();
+    m_uploadedLayout = store.layoutRevision();
+    return true;
+}
+
+void SceneBuffers::uploadAll(QOpenGLFunctions_3_3_Core *gl, const SceneStore& store) {
+    const BoxArrays& boxes = store.boxes();
+
+    bool wasCompact = m_compactUploaded;
+    m_compactUploaded = m_compactRequested && uploadCompact(gl, boxes);
+
+    if (!m_compactUploaded) {
+        // Plane offsets assume the buffer was sized for planes
+        if (wasCompact) m_capacity = 0;
+
+        // Only reallocate when the planes outgrow the buffer, edits that remove a few boxes reuse it
+        if (boxes.size() > m_capacity || boxes.size() < m_capacity / 2) {
+            m_capacity = boxes.size();
+            gl->glBufferData(GL_ARRAY_BUFFER, BoxArrays::PlaneCount * m_capacity * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+        }
+
+        for (int p = 0; p < BoxArrays::PlaneCount; ++p) {
+            if (boxes.isEmpty()) break;
+            gl->glBufferSubData(GL_ARRAY_BUFFER, planeOffset(p), boxes.size() * sizeof(float), boxes.plane(static_cast<BoxArrays::Plane>(p)));
+        }
+
+        m_uploadedBytes = BoxArrays::PlaneCount * boxes.size() * sizeof(float);
+    }
+
+    m_uploadedLayout = store.layoutRevision();
+    m_uploadedCount = boxes.size();
+    m_dirty = false;
+}
+
+bool SceneBuffers::uploadCompact(QOpenGLFunctions_3_3_Core *gl, const BoxArrays& boxes) {
+    // Both tables are one texture row, which the driver may not allow kMaxTemplates texels for
+    GLint maxTextureSize = 0;
+    gl->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    size_t maxTexels = std::min(kMaxTemplates, static_cast<size_t>(std::max(maxTextureSize, 1)));
+
+    std::vector<CompactBox> encoded;
+    std::vector<GLfloat> colours;
+    std::vector<GLfloat> originTable;
+    std::unordered_map<qint32, quint16> origins;
+    if (!encodeCompact(boxes, maxTexels, encoded, colours, originTable, origins)) return false;
+
+    if (!m_compactUploaded) m_capacity = 0;
+
+    if (boxes.size() > m_capacity || boxes.size() < m_capacity / 2) {
+        m_capacity = boxes.size();
+        gl->glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(CompactBox), nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    if (!encoded.empty()) {
+        gl->glBufferSubData(GL_ARRAY_BUFFER, 0, encoded.size() * sizeof(CompactBox), encoded.data());
+    }
+
+    m_templateCount = static_cast<GLsizei>(colours.size() / 3);
+    m_templateColours = colours;
+    m_originCount = static_cast<GLsizei>(originTable.size());
+    m_origins = std::move(origins);
+
+    uploadTable(gl, m_templateTexture, GL_RGB32F, GL_RGB, m_templateCount, colours.data());
+    uploadTable(gl, m_originTexture, GL_R32F, GL_RED, m_originCount, originTable.data());
+
+    m_uploadedBytes = encoded.size() * sizeof(CompactBox) + (colours.size() + originTable.size()) * sizeof(GLfloat);
+    return true;
+}
+
+void SceneBuffers::bindInstances(QOpenGLFunctions_3_3_Core *gl, const InstanceAttributes& attributes, size_t first) const {
+    gl->glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+
+    // VAOs remember enabled arrays, so the unused layout is switched off or it would read past the buffer
+    if (m_compactUploaded) {
+        for (GLint location : attributes.planes) {
+            if (location >= 0) gl->glDisableVertexAttribArray(location);
+        }
+
+        struct Field { GLint size; GLenum type; size_t offset; };
+        static const Field fields[CompactAttributeCount] = {
+            {3, GL_SHORT, offsetof(CompactBox, x)},
+            {3, GL_UNSIGNED_SHORT, offsetof(CompactBox, halfX)},
+            {1, GL_UNSIGNED_SHORT, offsetof(CompactBox, style)},
+            {1, GL_UNSIGNED_SHORT, offsetof(CompactBox, origin)}
+        };
+
+        for (int a = 0; a < CompactAttributeCount; ++a) {
+            GLint location = attributes.compact[a];
+            if (location < 0) continue;
+
+            const char* offset = reinterpret_cast<const char*>(first * sizeof(CompactBox) + fields[a].offset);
+
+            gl->glEnableVertexAttribArray(location);
+            gl->glVertexAttribPointer(location, fields[a].size, fields[a].type, GL_FALSE, sizeof(CompactBox), offset);
+            gl->glVertexAttribDivisor(location, 1);
+        }
+        return;
+    }
+
+    for (GLint location : attributes.compact) {
+        if (location >= 0) gl->glDisableVertexAttribArray(location);
+    }
+
+    for (int p = 0; p < BoxArrays::PlaneCount; ++p) {
+        GLint location = attributes.planes[p];
+        if (location < 0) continue;
+
+        const char* offset = reinterpret_cast<const char*>(planeOffset(p) + first * sizeof(float));
+
+        gl->glEnableVertexAttribArray(location);
+        gl->glVertexAttribPointer(location, 1, GL_FLOAT, GL_FALSE, sizeof(float), offset);
+        gl->glVertexAttribDivisor(location, 1);
+    }
+}
+
+void SceneBuffers::setDecodeUniforms(QOpenGLFunctions_3_3_Core *gl, QOpenGLShaderProgram *program, int textureUnit) const {
+    program->setUniformValue("uCompact", static_cast<GLint>(m_compactUploaded));
+    program->setUniformValue("uCompactStep", kCompactStep);
+
+    if (!m_compactUploaded) return;
+
+    program->setUniformValue("uTemplateColours", textureUnit);
+    program->setUniformValue("uTemplateCount", static_cast<GLfloat>(m_templateCount));
+    program->setUniformValue("uOrigins", textureUnit + 1);
+    program->setUniformValue("uOriginCount", static_cast<GLfloat>(m_originCount));
+
+    gl->glActiveTexture(GL_TEXTURE0 + textureUnit);
+    gl->glBindTexture(GL_TEXTURE_2D, m_templateTexture);
+    gl->glActiveTexture(GL_TEXTURE0 + textureUnit + 1);
+    gl->glBindTexture(GL_TEXTURE_2D, m_originTexture);
+    gl->glActiveTexture(GL_TEXTURE0);
+}
+
+void SceneBuffers::release(QOpenGLFunctions_3_3_Core *gl) {
+    GLuint buffers[] = {m_cubeBuffer, m_outlineBuffer, m_instanceBuffer};
+    if (m_instanceBuffer) gl->glDeleteBuffers(3, buffers);
+    if (m_templateTexture) gl->glDeleteTextures(1, &m_templateTexture);
+    if (m_originTexture) gl->glDeleteTextures(1, &m_originTexture);
+
+    m_cubeBuffer = 0;
+    m_outlineBuffer = 0;
+    m_instanceBuffer = 0;
+    m_templateTexture = 0;
+    m_originTexture = 0;
+    m_capacity = 0;
+    m_uploadedCount = 0;
+    m_compactUploaded = false;
+    m_dirty = true;
+}
@@ -0,0 +1,139 @@
+#ifndef SCENEBUFFERS_H
+#define SCENEBUFFERS_H
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+#include <array>
+#include <unordered_map>
+#include <vector>
+#include "SceneChangeSet.h"
+#include "SceneStore.h"
+
+// Box instances uploaded once and drawn by the 3D view and all three 2D views.
+// The instance buffer is the store's BoxArrays copied plane by plane, each plane feeding one
+// float attribute, so nothing is repacked on the way to the GPU. A watched store's edits are
+// patched in by range, only the planes of the fields that changed.
+// With setCompact(true) the buffer instead holds one 16-byte CompactBox per box, colour comes
+// from a per-template texture and each box's z origin from a second small texture; the shaders
+// decode either layout, picked by the uCompact uniform.
+// The views share one GL share group (Qt::AA_ShareOpenGLContexts), so buffer objects are
+// visible everywhere, but VAOs are not and every view keeps its own.
+class SceneBuffers {
+public:
+    // The centre and half sizes in steps of kCompactStep. Segments are only offset along z, so x, y
+    // and sizes keep their small in-segment values, and z is taken relative to the origin at index
+    // `origin` of the origin table. Origins are multiples of kOriginSpan, which stand in for segment
+    // origins since the store doesn't know where segments start. style is the template id times
+    // two plus the selected flag.
+    struct CompactBox {
+        qint16 x, y, z;
+        quint16 halfX, halfY, halfZ;
+        quint16 style;
+        quint16 origin;
+    };
+
+    static constexpr float kCompactStep = 1.0f / 128.0f;
+    static constexpr float kOriginSpan = 256.0f;
+
+    enum CompactAttribute { CompactXYZ, CompactHalf, CompactStyle, CompactOrigin, CompactAttributeCount };
+
+    // Attribute location of each plane in a shader, -1 for the ones it doesn't read
+    struct InstanceAttributes {
+        InstanceAttributes() { planes.fill(-1); compact.fill(-1); }
+        std::array<GLint, BoxArrays::PlaneCount> planes;
+        std::array<GLint, CompactAttributeCount> compact;
+    };
+
+    // Looks up the per-box attributes by their shared names, aCenterX through aSelected and aCompactXYZ through aCompactOrigin
+    static InstanceAttributes locate(QOpenGLShaderProgram *program);
+
+    SceneBuffers() = default;
+
+    // Subscribes to the store's changes. Stores that aren't watched are uploaded whole whenever
+    // their layout revision moves, which is enough for the headless renderer that never edits.
+    void watch(SceneStore *store) { m_changes.attach(store); }
+
+    // Brings the GPU copy up to date, cheap when nothing changed. Needs a current context.
+    void sync(QOpenGLFunctions_3_3_Core *gl, const SceneStore& store);
+
+    // Rebuild everything on the next sync
+    void invalidate() { m_dirty = true; }
+
+    // Asks for the compact layout from the next sync on. Scenes it can't hold exactly enough,
+    // coordinates out of range or boxes coloured unlike their template, stay on the float planes.
+    void setCompact(bool compact);
+    bool compactRequested() const { return m_compactRequested; }
+
+    // Whether the buffer holds the compact layout right now
+    bool isCompact() const { return m_compactUploaded; }
+
+    // Size of the last full instance upload
+    size_t uploadedBytes() const { return m_uploadedBytes; }
+
+    void release(QOpenGLFunctions_3_3_Core *gl);
+
+    // 36 vertices of a [-1, 1] cube, position xyz and texcoord uv
+    GLuint cubeBuffer() const { return m_cubeBuffer; }
+
+    // 12 GL_LINES vertices, the unit square outline and the centre X. z is 1 for the X.
+    GLuint outlineBuffer() const { return m_outlineBuffer; }
+
+    size_t instanceCount() const { return m_uploadedCount; }
+
+    // Points the instance attributes at instance `first`, so a run can be drawn with glDrawArraysInstanced.
+    // The other layout's attributes are disabled.
+    void bindInstances(QOpenGLFunctions_3_3_Core *gl, const InstanceAttributes& attributes, size_t first) const;
+
+    // Sets uCompact, uCompactStep, the template colour texture on textureUnit and the origin
+    // texture on the unit after it
+    void setDecodeUniforms(QOpenGLFunctions_3_3_Core *gl, QOpenGLShaderProgram *program, int textureUnit = 1) const;
+
+    // Calls draw(first, count) for each run of consecutive ids in a sorted list
+    template <typename Draw>
+    static void forEachRun(const std::vector<int>& sortedIds, Draw draw) {
+        size_t i = 0;
+        while (i < sortedIds.size()) {
+            size_t j = i + 1;
+            while (j < sortedIds.size() && sortedIds[j] == sortedIds[j - 1] + 1) ++j;
+            draw(static_cast<size_t>(sortedIds[i]), j - i);
+            i = j;
+        }
+    }
+
+private:
+    GLuint m_cubeBuffer = 0;
+    GLuint m_outlineBuffer = 0;
+    GLuint m_instanceBuffer = 0;
+    GLuint m_templateTexture = 0;
+    GLuint m_originTexture = 0;
+
+    size_t m_capacity = 0;  // Boxes each plane has room for
+    size_t m_uploadedCount = 0;
+
+    SceneChangeSet m_changes;
+    bool m_dirty = true;
+    quint64 m_uploadedLayout = 0;
+
+    bool m_compactRequested = false;
+    bool m_compactUploaded = false;
+    GLsizei m_templateCount = 1;
+    GLsizei m_originCount = 1;
+    std::vector<GLfloat> m_templateColours;  // What the texture holds, patched boxes must match it
+    std::unordered_map<qint32, quint16> m_origins;  // Origin table index of each z band in use
+    size_t m_uploadedBytes = 0;
+
+    void createStaticBuffers(QOpenGLFunctions_3_3_Core *gl);
+    void uploadAll(QOpenGLFunctions_3_3_Core *gl, const SceneStore& store);
+    bool uploadCompact(QOpenGLFunctions_3_3_Core *gl, const BoxArrays& boxes);
+
+    // Uploads only the changed ranges, false if that can't be done and a full upload is needed
+    bool uploadChanges(QOpenGLFunctions_3_3_Core *gl, const SceneStore& store);
+
+    GLintptr planeOffset(int plane) const { return static_cast<GLintptr>(plane * m_capacity * sizeof(float)); }
+
+    // Rewrites the compact records of [first, last), false if one no longer fits the encoding or moved
+    // to a z band without an origin. With checkColours set, also if one's colour differs from its template's texel.
+    bool uploadCompactRange(QOpenGLFunctions_3_3_Core *gl, const BoxArrays& boxes, size_t first, size_t last, bool checkColours);
+};
+
+#endif // SCENEBUFFERS_H
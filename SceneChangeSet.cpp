@@ -0,0 +1,103 @@
+#include "SceneChangeSet.h"
+#include <algorithm>
+
+void SceneChangeSet::attach(SceneStore *store) {
+    if (store == m_store) return;
+
+    if (m_store) m_store->unsubscribe(this);
+    m_store = store;
+    if (m_store) m_store->subscribe(this);
+
+    clear();
+    m_reset = true;
+}
+
+void SceneChangeSet::sceneChanged(const SceneChange& change) {
+    switch (change.kind) {
+    case SceneChange::Reset:
+        clear();
+        m_reset = true;
+        break;
+
+    case SceneChange::Inserted:
+        add(change.first, change.last, SceneChange::AllFields);
+        break;
+
+    case SceneChange::Removed: {
+        if (m_reset) break;
+
+        // Sent before the removal, the store still has its old size
+        size_t remaining = m_store->size() - (change.last - change.first);
+
+        for (size_t i = change.first; i < change.last; ++i) m_removed.push_back(m_store->handleAt(i));
+
+        // Boxes from the end move into the hole, ranges past the new end are dropped in ranges()
+        if (change.first < remaining) add(change.first, std::min(change.last, remaining), SceneChange::AllFields);
+        break;
+    }
+
+    case SceneChange::Modified:
+        add(change.first, change.last, change.fields);
+        break;
+    }
+}
+
+void SceneChangeSet::add(size_t first, size_t last, quint32 fields) {
+    if (m_reset || first >= last) return;
+
+    m_fields |= fields;
+
+    // Drags and bulk edits mostly touch neighbours in order, extend the last range when they do
+    if (!m_ranges.empty()) {
+        Range& back = m_ranges.back();
+        if (first <= back.last && last >= back.first) {
+            back.first = std::min(back.first, first);
+            back.last = std::max(back.last, last);
+            back.fields |= fields;
+            return;
+        }
+        if (first < back.first) m_normalized = false;
+    }
+
+    m_ranges.push_back({first, last, fields});
+}
+
+const std::vector<SceneChangeSet::Range>& SceneChangeSet::ranges() {
+    size_t size = m_store ? m_store->size() : 0;
+
+    if (!m_normalized) {
+        std::sort(m_ranges.begin(), m_ranges.end(), [](const Range& a, const Range& b) { return a.first < b.first; });
+        m_normalized = true;
+    }
+
+    // Merge touching ranges and drop what's past the end
+    size_t out = 0;
+    for (const Range& range : m_ranges) {
+        if (range.first >= size) break;
+
+        Range clipped{range.first, std::min(range.last, size), range.fields};
+        if (out > 0 && clipped.first <= m_ranges[out - 1].last) {
+            m_ranges[out - 1].last = std::max(m_ranges[out - 1].last, clipped.last);
+            m_ranges[out - 1].fields |= clipped.fields;
+        } else {
+            m_ranges[out++] = clipped;
+        }
+    }
+    m_ranges.resize(out);
+
+    return m_ranges;
+}
+
+size_t SceneChangeSet::dirtyCount() {
+    size_t count = 0;
+    for (const Range& range : ranges()) count += range.last - range.first;
+    return count;
+}
+
+void SceneChangeSet::clear() {
+    m_ranges.clear();
+    m_removed.clear();
+    m_fields = 0;
+    m_reset = false;
+    m_normalized = true;
+}
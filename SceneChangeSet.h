@@ -0,0 +1,62 @@
+#ifndef SCENECHANGESET_H
+#define SCENECHANGESET_H
+
+#include <vector>
+#include "SceneStore.h"
+
+// Collects a store's changes between two updates of whoever owns it, as dirty index ranges and
+// the fields that changed in them. Inserted boxes are dirty in every field. A removal dirties the
+// hole the last box moves into and shrinks the store, so owners compare their own count with size().
+class SceneChangeSet : public SceneListener {
+public:
+    struct Range {
+        size_t first;
+        size_t last;
+        quint32 fields;
+    };
+
+    SceneChangeSet() = default;
+    ~SceneChangeSet() override { attach(nullptr); }
+
+    SceneChangeSet(const SceneChangeSet&) = delete;
+    SceneChangeSet& operator=(const SceneChangeSet&) = delete;
+
+    // Subscribes to store, nullptr unsubscribes. Starts out reset so the first update is a full one.
+    void attach(SceneStore *store);
+    bool isAttached() const { return m_store != nullptr; }
+
+    void sceneChanged(const SceneChange& change) override;
+    void sceneDestroyed() override { m_store = nullptr; }
+
+    bool isEmpty() const { return !m_reset && m_ranges.empty() && m_removed.empty(); }
+
+    // The ranges don't cover it, rebuild everything
+    bool isReset() const { return m_reset; }
+    void markReset() { m_reset = true; }
+
+    // Sorted, merged and cut to the store's current size
+    const std::vector<Range>& ranges();
+
+    // Boxes covered by ranges()
+    size_t dirtyCount();
+
+    // Union of the fields of every range
+    quint32 fields() const { return m_fields; }
+
+    // Handles of removed boxes, taken while they still resolved. Undo may have brought some back.
+    const std::vector<BoxHandle>& removedHandles() const { return m_removed; }
+
+    void clear();
+
+private:
+    SceneStore *m_store = nullptr;
+    std::vector<Range> m_ranges;
+    std::vector<BoxHandle> m_removed;
+    quint32 m_fields = 0;
+    bool m_reset = true;
+    bool m_normalized = true;
+
+    void add(size_t first, size_t last, quint32 fields);
+};
+
+#endif // SCENECHANGESET_H
@@ -0,0 +1,327 @@
+#include "SceneStore.h"
+#include <algorithm>
+
+namespace {
+
+// Calls run(first, last) for each stretch of consecutive values in sorted, last to first when
+// backwards is set
+template <typename Run>
+void forEachRun(const std::vector<size_t>& sorted, bool backwards, Run run) {
+    std::vector<std::pair<size_t, size_t>> runs;
+
+    size_t i = 0;
+    while (i < sorted.size()) {
+        size_t j = i + 1;
+        while (j < sorted.size() && sorted[j] == sorted[j - 1] + 1) ++j;
+        runs.emplace_back(sorted[i], sorted[j - 1] + 1);
+        i = j;
+    }
+
+    if (backwards) std::reverse(runs.begin(), runs.end());
+    for (const auto& [first, last] : runs) run(first, last);
+}
+
+}
+
+quint32 SceneChange::fieldOf(BoxArrays::Plane plane) {
+    switch (plane) {
+    case BoxArrays::X:
+    case BoxArrays::Y:
+    case BoxArrays::Z:
+        return Position;
+    case BoxArrays::Width:
+    case BoxArrays::Height:
+    case BoxArrays::Depth:
+        return Size;
+    case BoxArrays::Red:
+    case BoxArrays::Green:
+    case BoxArrays::Blue:
+        return Colour;
+    case BoxArrays::Selected:
+        return Selected;
+    default:
+        return 0;
+    }
+}
+
+SceneStore::~SceneStore() {
+    // Widgets holding a listener can outlive the store that owns their boxes
+    std::vector<SceneListener*> listeners = std::move(m_listeners);
+    for (SceneListener *listener : listeners) listener->sceneDestroyed();
+}
+
+void SceneStore::subscribe(SceneListener *listener) {
+    if (std::find(m_listeners.begin(), m_listeners.end(), listener) == m_listeners.end()) m_listeners.push_back(listener);
+}
+
+void SceneStore::unsubscribe(SceneListener *listener) {
+    m_listeners.erase(std::remove(m_listeners.begin(), m_listeners.end(), listener), m_listeners.end());
+}
+
+BoxHandle SceneStore::insert(const Rect3D& rect, InternedString templateType) {
+    quint32 slot = acquireSlot(static_cast<quint32>(m_boxes.size()));
+    m_boxes.append(rect.position(), rect.size(), rect.getColour(), templateType);
+    m_boxSlots.push_back(slot);
+
+    m_layoutRevision++;
+    notify(SceneChange::Inserted, m_boxes.size() - 1, m_boxes.size());
+    return {slot, m_slots[slot].generation};
+}
+
+std::vector<BoxHandle> SceneStore::insert(const BoxArrays& boxes) {
+    std::vector<BoxHandle> handles;
+    handles.reserve(boxes.size());
+
+    size_t first = m_boxes.size();
+    m_boxes.append(boxes);
+    m_boxSlots.reserve(m_boxes.size());
+
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        quint32 slot = acquireSlot(static_cast<quint32>(first + i));
+        m_boxSlots.push_back(slot);
+        handles.push_back({slot, m_slots[slot].generation});
+    }
+
+    m_layoutRevision++;
+    if (!boxes.isEmpty()) notify(SceneChange::Inserted, first, m_boxes.size());
+    return handles;
+}
+
+bool SceneStore::remove(BoxHandle handle) {
+    int index = indexOf(handle);
+    if (index < 0) return false;
+
+    // Before anything moves, so listeners can still look the box up
+    notify(SceneChange::Removed, index, index + 1);
+    erase(index);
+
+    m_layoutRevision++;
+    return true;
+}
+
+size_t SceneStore::remove(const std::vector<BoxHandle>& handles) {
+    std::vector<size_t> indices = indicesOf(handles);
+    if (indices.empty()) return 0;
+
+    // Highest run first, the boxes moved into its hole come from past it and aren't being removed
+    forEachRun(indices, true, [this](size_t first, size_t last) {
+        notify(SceneChange::Removed, first, last);
+        for (size_t index = last; index-- > first;) erase(index);
+    });
+
+    m_layoutRevision++;
+    return indices.size();
+}
+
+void SceneStore::erase(size_t index) {
+    quint32 slot = m_boxSlots[index];
+
+    // Keep the boxes packed by moving the last one into the hole
+    size_t last = m_boxes.size() - 1;
+    if (index != last) {
+        m_boxSlots[index] = m_boxSlots[last];
+        m_slots[m_boxSlots[index]].index = static_cast<quint32>(index);
+    }
+
+    m_boxes.swapRemove(index);
+    m_boxSlots.pop_back();
+
+    releaseSlot(slot);
+}
+
+bool SceneStore::restore(BoxHandle handle, const Rect3D& rect, InternedString templateType) {
+    if (!revive(handle, rect, templateType)) return false;
+
+    m_layoutRevision++;
+    notify(SceneChange::Inserted, m_boxes.size() - 1, m_boxes.size());
+    return true;
+}
+
+size_t SceneStore::restore(const std::vector<BoxHandle>& handles, const BoxArrays& boxes) {
+    size_t first = m_boxes.size();
+
+    for (size_t i = 0; i < handles.size() && i < boxes.size(); ++i) revive(handles[i], boxes.box(i), boxes.templateType(i));
+
+    size_t count = m_boxes.size() - first;
+    if (count == 0) return 0;
+
+    m_layoutRevision++;
+    notify(SceneChange::Inserted, first, m_boxes.size());
+    return count;
+}
+
+bool SceneStore::revive(BoxHandle handle, const Rect3D& rect, InternedString templateType) {
+    if (handle.slot >= m_slots.size()) return false;
+
+    Slot& slot = m_slots[handle.slot];
+    if (!isFree(slot) || handle.generation > slot.latest) return false;
+
+    // Leave the slot in m_freeSlots, acquireSlot() skips it while it's live
+    slot.generation = handle.generation;
+    slot.index = static_cast<quint32>(m_boxes.size());
+
+    m_boxes.append(rect.position(), rect.size(), rect.getColour(), templateType);
+    m_boxSlots.push_back(handle.slot);
+    return true;
+}
+
+void SceneStore::assign(BoxArrays boxes) {
+    releaseAll();
+
+    m_boxes = std::move(boxes);
+    size_t count = m_boxes.size();
+
+    // One generation newer than any slot handed out, shared by every assigned box
+    quint32 generation = 0;
+    for (const Slot& slot : m_slots) generation = std::max(generation, slot.latest + 1);
+
+    if (m_slots.size() < count) m_slots.resize(count);
+
+    // Every slot is free after releaseAll(). Queue the ones past the boxes, lowest on top.
+    m_freeSlots.clear();
+    for (size_t slot = m_slots.size(); slot-- > count;) {
+        m_slots[slot].queued = true;
+        m_freeSlots.push_back(static_cast<quint32>(slot));
+    }
+
+    m_boxSlots.resize(count);
+    for (quint32 i = 0; i < count; ++i) {
+        m_slots[i] = {generation, generation, i, false};
+        m_boxSlots[i] = i;
+    }
+
+    m_assignGeneration = generation;
+    m_assignCount = count;
+
+    m_layoutRevision++;
+    notify(SceneChange::Reset, 0, 0);
+}
+
+void SceneStore::clear() {
+    releaseAll();
+    m_assignCount = 0;
+
+    m_layoutRevision++;
+    notify(SceneChange::Reset, 0, 0);
+}
+
+void SceneStore::releaseAll() {
+    for (quint32 slot : m_boxSlots) releaseSlot(slot);
+
+    m_boxes.clear();
+    m_boxSlots.clear();
+}
+
+std::optional<Rect3D> SceneStore::find(BoxHandle handle) const {
+    int index = indexOf(handle);
+    if (index < 0) return std::nullopt;
+    return m_boxes.box(index);
+}
+
+bool SceneStore::isSelected(BoxHandle handle) const {
+    int index = indexOf(handle);
+    return index >= 0 && m_boxes.isSelected(index);
+}
+
+bool SceneStore::setSelected(BoxHandle handle, bool selected) {
+    int index = indexOf(handle);
+    if (index < 0) return false;
+
+    if (m_boxes.isSelected(index) != selected) {
+        m_boxes.setSelected(index, selected);
+        notify(SceneChange::Modified, index, index + 1, SceneChange::Selected);
+    }
+    return true;
+}
+
+size_t SceneStore::setSelected(const std::vector<BoxHandle>& handles, bool selected) {
+    std::vector<size_t> indices = indicesOf(handles);
+    indices.erase(std::remove_if(indices.begin(), indices.end(), [this, selected](size_t index) {
+        return m_boxes.isSelected(index) == selected;
+    }), indices.end());
+
+    forEachRun(indices, false, [this, selected](size_t first, size_t last) {
+        for (size_t index = first; index < last; ++index) m_boxes.setSelected(index, selected);
+        notify(SceneChange::Modified, first, last, SceneChange::Selected);
+    });
+    return indices.size();
+}
+
+bool SceneStore::setValue(BoxHandle handle, BoxArrays::Plane plane, float value) {
+    int index = indexOf(handle);
+    if (index < 0) return false;
+
+    m_boxes.setValue(index, plane, value);
+    notify(SceneChange::Modified, index, index + 1, SceneChange::fieldOf(plane));
+    return true;
+}
+
+void SceneStore::translate(const std::vector<BoxHandle>& handles, const QVector3D& delta) {
+    if (delta.isNull()) return;
+
+    // A selection loaded together sits together, so a drag is usually a few runs and a few events
+    forEachRun(indicesOf(handles), false, [this, &delta](size_t first, size_t last) {
+        m_boxes.translate(first, last, delta);
+        notify(SceneChange::Modified, first, last, SceneChange::Position);
+    });
+}
+
+std::vector<size_t> SceneStore::indicesOf(const std::vector<BoxHandle>& handles) const {
+    std::vector<size_t> indices;
+    indices.reserve(handles.size());
+
+    for (BoxHandle handle : handles) {
+        int index = indexOf(handle);
+        if (index >= 0) indices.push_back(static_cast<size_t>(index));
+    }
+
+    // Handles may repeat, each box counts once
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    return indices;
+}
+
+int SceneStore::indexOf(BoxHandle handle) const {
+    if (handle.slot >= m_slots.size()) return -1;
+
+    const Slot& slot = m_slots[handle.slot];
+    if (slot.generation != handle.generation) return -1;
+
+    // A free slot's generation is one nobody was handed, so a match means the slot is live
+    return static_cast<int>(slot.index);
+}
+
+quint32 SceneStore::acquireSlot(quint32 index) {
+    // Reuse freed slots first. Each reuse takes a generation newer than any handed out before,
+    // so neither old handles nor ones a later restore() could bring back will match it.
+    while (!m_freeSlots.empty()) {
+        quint32 slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_slots[slot].queued = false;
+
+        if (!isFree(m_slots[slot])) continue;  // Restored since it was queued
+
+        m_slots[slot].latest = m_slots[slot].generation;
+        m_slots[slot].index = index;
+        return slot;
+    }
+
+    quint32 slot = static_cast<quint32>(m_slots.size());
+    m_slots.push_back(Slot());
+    m_slots[slot].index = index;
+    return slot;
+}
+
+void SceneStore::notify(SceneChange::Kind kind, size_t first, size_t last, quint32 fields) {
+    SceneChange change{kind, first, last, fields};
+    for (SceneListener *listener : m_listeners) listener->sceneChanged(change);
+}
+
+void SceneStore::releaseSlot(quint32 slot) {
+    m_slots[slot].generation = m_slots[slot].latest + 1;
+
+    if (!m_slots[slot].queued) {
+        m_slots[slot].queued = true;
+        m_freeSlots.push_back(slot);
+    }
+}
@@ -0,0 +1,184 @@
+#ifndef SCENESTORE_H
+#define SCENESTORE_H
+
+#include <QMetaType>
+#include <optional>
+#include <vector>
+#include "BoxArrays.h"
+
+// Refers to one box in a SceneStore. Stays safe to hold after any insert or remove,
+// a removed box's handle simply stops resolving.
+struct BoxHandle {
+    static constexpr quint32 kNullSlot = 0xFFFFFFFFu;
+
+    quint32 slot = kNullSlot;
+    quint32 generation = 0;
+
+    bool isNull() const { return slot == kNullSlot; }
+
+    bool operator==(const BoxHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const BoxHandle& other) const { return !(*this == other); }
+    bool operator<(const BoxHandle& other) const {
+        return slot != other.slot ? slot < other.slot : generation < other.generation;
+    }
+};
+
+Q_DECLARE_METATYPE(BoxHandle)
+
+// One edit to SceneStore::boxes(), as a range of box indices
+struct SceneChange {
+    enum Kind {
+        Reset,     // Every box was replaced, the range is empty
+        Inserted,  // [first, last) were appended
+        Removed,   // [first, last) are about to go, their handles still resolve. The last boxes then move into the hole.
+        Modified   // fields of [first, last) changed
+    };
+
+    enum Field : quint32 {
+        Position = 1,
+        Size = 2,
+        Colour = 4,
+        Selected = 8,
+        Template = 16,
+        AllFields = 31
+    };
+
+    Kind kind;
+    size_t first;
+    size_t last;
+    quint32 fields;
+
+    static quint32 fieldOf(BoxArrays::Plane plane);
+};
+
+// Told about every change to a store, synchronously, from inside the edit
+class SceneListener {
+public:
+    virtual ~SceneListener() = default;
+    virtual void sceneChanged(const SceneChange& change) = 0;
+
+    // The store is going away while still subscribed, forget it without unsubscribing
+    virtual void sceneDestroyed() {}
+};
+
+// Owns the boxes of the open asset. Boxes sit packed in BoxArrays, in the order they were
+// loaded, so the renderers and the GPU upload read them directly. Handles go through a slot
+// table; removing a box moves the last one into its place and retires the slot's generation.
+// Every edit is announced to the subscribed listeners, so caches patch what changed instead
+// of rebuilding.
+class SceneStore {
+public:
+    SceneStore() = default;
+    ~SceneStore();
+
+    // Listeners are subscribed to this store, not to its boxes
+    SceneStore(const SceneStore&) = delete;
+    SceneStore& operator=(const SceneStore&) = delete;
+
+    void subscribe(SceneListener *listener);
+    void unsubscribe(SceneListener *listener);
+
+    BoxHandle insert(const Rect3D& rect, InternedString templateType = InternedString());
+
+    // Adds every box of boxes at once, handles in the same order
+    std::vector<BoxHandle> insert(const BoxArrays& boxes);
+
+    // False if the handle was already stale
+    bool remove(BoxHandle handle);
+
+    // Removes every box of handles that still resolves, with one notification per run of
+    // neighbouring boxes. Returns how many went.
+    size_t remove(const std::vector<BoxHandle>& handles);
+
+    // Brings a removed box back under its old handle, so anything still holding the handle
+    // resolves again. False if the slot is live or the handle was never handed out.
+    bool restore(BoxHandle handle, const Rect3D& rect, InternedString templateType);
+
+    // Brings back box i of boxes under handles[i] for each handle restore() would take, all in
+    // one run at the end and one notification. Returns how many came back.
+    size_t restore(const std::vector<BoxHandle>& handles, const BoxArrays& boxes);
+
+    // Replaces every box, all earlier handles go stale. Box n gets slot n, so its handle is
+    // assignedHandle(n) for as long as it lives.
+    void assign(BoxArrays boxes);
+    void clear();
+
+    // Handle of the nth box the last assign() was given, stale once that box is removed.
+    // Lets an outline of the loaded file name its boxes by position alone.
+    BoxHandle assignedHandle(size_t n) const { return {static_cast<quint32>(n), m_assignGeneration}; }
+
+    // n for a handle assignedHandle(n) gives, -1 for boxes that came from somewhere else
+    int assignedIndex(BoxHandle handle) const {
+        return handle.slot < m_assignCount && handle.generation == m_assignGeneration ? static_cast<int>(handle.slot) : -1;
+    }
+
+    bool contains(BoxHandle handle) const { return indexOf(handle) >= 0; }
+
+    // Empty for stale handles
+    std::optional<Rect3D> find(BoxHandle handle) const;
+    Rect3D box(size_t index) const { return m_boxes.box(index); }
+
+    // False for stale handles
+    bool isSelected(BoxHandle handle) const;
+    bool setSelected(BoxHandle handle, bool selected);
+
+    // Sets the flag of every box of handles that resolves, with one notification per run of
+    // neighbouring boxes it changed. Returns how many changed.
+    size_t setSelected(const std::vector<BoxHandle>& handles, bool selected);
+    bool setValue(BoxHandle handle, BoxArrays::Plane plane, float value);
+
+    void translate(const std::vector<BoxHandle>& handles, const QVector3D& delta);
+
+    // Position in boxes(), -1 for stale handles
+    int indexOf(BoxHandle handle) const;
+    BoxHandle handleAt(size_t index) const { return {m_boxSlots[index], m_slots[m_boxSlots[index]].generation}; }
+
+    const BoxArrays& boxes() const { return m_boxes; }
+
+    size_t size() const { return m_boxes.size(); }
+    bool isEmpty() const { return m_boxes.isEmpty(); }
+
+    // Bumped when boxes are added, removed or reordered. For caches that don't subscribe, which
+    // can only rebuild; moving a box in place doesn't count.
+    quint64 layoutRevision() const { return m_layoutRevision; }
+
+private:
+    struct Slot {
+        quint32 generation = 0;  // Of the live box, one past latest while the slot is free
+        quint32 latest = 0;      // Newest generation handed out, restore() may go back below it
+        quint32 index = 0;       // Into m_boxes while live
+        bool queued = false;     // In m_freeSlots. A restored slot stays there until it's popped.
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<quint32> m_freeSlots;
+
+    BoxArrays m_boxes;
+    std::vector<quint32> m_boxSlots;  // Slot of each box in m_boxes
+
+    quint64 m_layoutRevision = 0;
+
+    quint32 m_assignGeneration = 0;
+    size_t m_assignCount = 0;
+
+    std::vector<SceneListener*> m_listeners;
+
+    void notify(SceneChange::Kind kind, size_t first, size_t last, quint32 fields = SceneChange::AllFields);
+
+    bool isFree(const Slot& slot) const { return slot.generation > slot.latest; }
+
+    // Sorted indices of the handles that resolve
+    std::vector<size_t> indicesOf(const std::vector<BoxHandle>& handles) const;
+
+    // Swap-removes the box at index and frees its slot, without notifying
+    void erase(size_t index);
+
+    // Appends the box under handle if restore() would take it, without notifying
+    bool revive(BoxHandle handle, const Rect3D& rect, InternedString templateType);
+
+    quint32 acquireSlot(quint32 index);
+    void releaseAll();
+    void releaseSlot(quint32 slot);
+};
+
+#endif // SCENESTORE_H
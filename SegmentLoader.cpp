@@ -1,39 +1,36 @@
 #include "SegmentLoader.h"
 #include "qxmlstream.h"
+#include <optional>
 
-std::array<GLfloat, 3> loadColour(QString rootDir, QString tempName) {
+Loader::TemplateTable::TemplateTable(const QString& rootDir) {
     QFile file(rootDir + "/templates.xml");
 
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         QMessageBox::warning(nullptr, "Error", "Failed to open template file");
-        return {1.f, 1.f, 1.f};
+        return;
     }
 
     QXmlStreamReader xml(&file);
-    std::array<GLfloat, 3> colour;
 
     while (!xml.atEnd() && !xml.hasError()) {
         xml.readNext();
 
-        if (xml.isStartElement() && xml.name().toString() == "template") {
-            if (xml.attributes().value("name") == tempName) {
-                // Inside the correct <template> tag
-                while (!(xml.isEndElement() && xml.name().toString() == "template")) {
-                    xml.readNext();
-
-                    if (xml.isStartElement() && xml.name().toString() == "properties") {
-                        QString colorAttr = xml.attributes().value("color").toString();
-                        QStringList values = colorAttr.split(" ");
-
-                        if (values.size() == 3) {
-                            colour[0] = values[0].toFloat();
-                            colour[1] = values[1].toFloat();
-                            colour[2] = values[2].toFloat();
-                        }
-                        break;  // Found color, exit inner loop
+        if (xml.isStartElement() && xml.name() == QLatin1String("template")) {
+            InternedString name(xml.attributes().value("name"));
+
+            // The colour is on the template's <properties> element
+            while (!xml.atEnd() && !(xml.isEndElement() && xml.name() == QLatin1String("template"))) {
+                xml.readNext();
+
+                if (xml.isStartElement() && xml.name() == QLatin1String("properties")) {
+                    QStringList values = xml.attributes().value("color").toString().split(" ");
+
+                    if (values.size() == 3) {
+                        if (name.id() >= m_colours.size()) m_colours.resize(name.id() + 1, {1.f, 1.f, 1.f});
+                        m_colours[name.id()] = {values[0].toFloat(), values[1].toFloat(), values[2].toFloat()};
                     }
+                    break;
                 }
-                break;  // Found the template, exit main loop
             }
         }
     }
@@ -41,12 +38,15 @@ std::array<GLfloat, 3> loadColour(QString rootDir, QString tempName) {
     if (xml.hasError()) {
         QMessageBox::warning(nullptr, "Error", "Error parsing templates.xml: " + xml.errorString());
     }
+}
 
-    file.close();
-    return colour;
+std::array<GLfloat, 3> Loader::TemplateTable::colour(InternedString templateType) const {
+    if (templateType.id() >= m_colours.size()) return {1.f, 1.f, 1.f};
+    return m_colours[templateType.id()];
 }
 
-Segment Loader::loadLevelSegment(const QString& rootDir, const QString& filename, const bool useRootDir) {
+Segment Loader::loadLevelSegment(const QString& rootDir, const QString& filename, const bool useRootDir,
+                                 std::pmr::memory_resource* resource, const TemplateTable* templates) {
     QString path;
 
     if (useRootDir) path = rootDir + filename;
@@ -56,11 +56,15 @@ Segment Loader::loadLevelSegment(const QString& rootDir, const QString& filename
     QFile file(path);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         QMessageBox::warning(nullptr, "Error", "Failed to open file: " + path);
-        return Segment();
+        return Segment(resource);
     }
 
     QXmlStreamReader xml(&file);
-    Segment segment;
+    Segment segment(resource);
+
+    // A segment opened on its own reads the templates for just this load
+    std::optional<TemplateTable> ownTemplates;
+    if (!templates) templates = &ownTemplates.emplace(rootDir);
 
     // Find last '/' or '\\'
     size_t lastSlash = filename.toStdString().find_last_of("/\\");
@@ -83,11 +87,12 @@ Segment Loader::loadLevelSegment(const QString& rootDir, const QString& filename
                 if (sizeParts.size() == 3)
                     segment.size = QVector3D(sizeParts[0].toFloat(), sizeParts[1].toFloat(), sizeParts[2].toFloat());
 
-                segment.templateType = xml.attributes().value("template").toString();
+                segment.templateType = InternedString(xml.attributes().value("template"));
             }
 
             else if (name == "box") {
-                Box box;
+                // Built in place in the segment's list, the only copy of it the load makes
+                Box& box = segment.boxes.emplace_back();
 
                 QStringList sizeParts = xml.attributes().value("size").toString().split(' ');
                 QStringList posParts = xml.attributes().value("pos").toString().split(' ');
@@ -99,25 +104,21 @@ Segment Loader::loadLevelSegment(const QString& rootDir, const QString& filename
                     box.pos = QVector3D(posParts[0].toFloat(), posParts[1].toFloat(), posParts[2].toFloat());
 
                 box.hidden = xml.attributes().value("hidden").toInt();
-                box.templateType = xml.attributes().value("template").toString();
-                box.colour = loadColour(rootDir, box.templateType);
-
-                segment.boxes.push_back(box);
+                box.templateType = InternedString(xml.attributes().value("template"));
+                box.colour = templates->colour(box.templateType);
             }
 
             else if (name == "obstacle") {
-                Obstacle obs;
+                Obstacle& obs = segment.obstacles.emplace_back();
 
                 QStringList posParts = xml.attributes().value("pos").toString().split(' ');
                 if (posParts.size() == 3)
                     obs.pos = QVector3D(posParts[0].toFloat(), posParts[1].toFloat(), posParts[2].toFloat());
 
                 obs.hidden = xml.attributes().value("hidden").toInt();
-                obs.type = xml.attributes().value("type").toString();
-                obs.templateType = xml.attributes().value("template").toString();
+                obs.type = InternedString(xml.attributes().value("type"));
+                obs.templateType = InternedString(xml.attributes().value("template"));
                 obs.mode = xml.attributes().hasAttribute("mode") ? xml.attributes().value("mode").toInt() : 0;
-
-                segment.obstacles.push_back(obs);
             }
         }
     }
@@ -125,12 +126,15 @@ Segment Loader::loadLevelSegment(const QString& rootDir, const QString& filename
     return segment;
 }
 
-std::vector<Rect3D> Loader::getRects(const std::vector<Box>& boxes) {
-    std::vector<Rect3D> rects;
+BoxArrays Loader::getBoxArrays(const std::pmr::vector<Box>& boxes) {
+    BoxArrays arrays;
+    appendBoxes(arrays, boxes);
+    return arrays;
+}
+
+void Loader::appendBoxes(BoxArrays& arrays, const std::pmr::vector<Box>& boxes) {
+    arrays.reserve(arrays.size() + boxes.size());
     for (const Box& box : boxes) {
-        Rect3D newRect(box.pos, box.size);
-        newRect.setColour(box.colour);
-        rects.push_back(newRect);
+        arrays.append(box.pos, box.size, box.colour, box.templateType);
     }
-    return rects;
 }
@@ -5,37 +5,72 @@
 #include <QDomDocument>
 #include <QDebug>
 #include <QMessageBox>
-#include "Rect3D.h"
+#include <memory_resource>
+#include <vector>
+#include "BoxArrays.h"
+#include "CopyCounter.h"
+#include "InternedString.h"
 
 struct Box {
     QVector3D size;
     QVector3D pos;
     bool hidden;
-    QString templateType;
+    InternedString templateType;
     std::array<GLfloat, 3> colour = {1.0f, 1.0f, 1.0f};
+
+    // A box is built once by the parser and only read after, the self-test checks nothing copies it
+    CopyCounter<Box> copies;
 };
 
 struct Obstacle {
     QVector3D pos;
     bool hidden;
-    QString type;
-    QString templateType;
+    InternedString type;
+    InternedString templateType;
     int mode;
 };
 
 struct Segment {
+    // The box and obstacle lists allocate from resource, normally the arena of the load that read them
+    explicit Segment(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : boxes(resource), obstacles(resource) {}
+
+    // Move-only, a copy would duplicate every box onto the default heap
+    Segment(Segment&&) = default;
+    Segment& operator=(Segment&&) = default;
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
     QVector3D size;
-    QString templateType;
+    InternedString templateType;
     QString name;
     float offset;
-    std::vector<Box> boxes;
-    std::vector<Obstacle> obstacles;
+    std::pmr::vector<Box> boxes;
+    std::pmr::vector<Obstacle> obstacles;
 };
 
 namespace Loader {
-    Segment loadLevelSegment(const QString& rootDir, const QString& filename, const bool useRootDir);
+    // Colours from rootDir/templates.xml, indexed by the template's interned id. Each load reads
+    // its own and hands it down to the segments it opens, so edits to the file show on the next load.
+    class TemplateTable {
+    public:
+        explicit TemplateTable(const QString& rootDir);
+
+        // White for unknown templates, and for all of them if the file couldn't be read.
+        // Colours before a parse error are kept.
+        std::array<GLfloat, 3> colour(InternedString templateType) const;
+
+    private:
+        std::vector<std::array<GLfloat, 3>> m_colours;
+    };
+
+    // Without templates, the segment reads rootDir's table itself
+    Segment loadLevelSegment(const QString& rootDir, const QString& filename, const bool useRootDir,
+                             std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                             const TemplateTable* templates = nullptr);
 
-    std::vector<Rect3D> getRects(const std::vector<Box>& boxes);
+    BoxArrays getBoxArrays(const std::pmr::vector<Box>& boxes);
+    void appendBoxes(BoxArrays& arrays, const std::pmr::vector<Box>& boxes);
 }
 
 #endif // SEGMENTLOADER_H
@@ -0,0 +1,604 @@
+#include "SegmentRenderer.h"
+#include "TextureLoader.h"
+#include "TextureExtractor.h"
+#include <QOpenGLContext>
+#include <QVector2D>
+#include <QVector4D>
+#include <QtMath>
+#include <GL/glu.h>
+#include <algorithm>
+
+void SegmentRenderer::initialize(const QString& rootDir) {
+    m_rootDir = rootDir;
+
+    initializeOpenGLFunctions();
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glFrontFace(GL_CCW);
+    glClearDepth(1.0);
+    glDepthMask(GL_TRUE); // Ensure depth writing
+
+    qDebug() << "Loading room program!";
+
+    m_roomProgram = createShaderProgram("room");
+
+    qDebug() << "Loading clear program!";
+    m_clearProgram = createShaderProgram("clear");
+    m_basicProgram = createShaderProgram("basic");
+    m_instancedProgram = createShaderProgram("instanced");
+
+    glGenVertexArrays(1, &m_cubeVao);
+
+    m_profiler.initialize(this);
+
+    loadTileTexture();
+}
+
+void SegmentRenderer::release() {
+    m_profiler.release();
+
+    // Shared buffers belong to the whole share group and outlive any one view
+    if (m_buffers == &m_ownBuffers) m_ownBuffers.release(this);
+    if (m_cubeVao) glDeleteVertexArrays(1, &m_cubeVao);
+
+    delete m_roomProgram;
+    delete m_clearProgram;
+    delete m_basicProgram;
+    delete m_instancedProgram;
+    delete tileTex;
+
+    m_roomProgram = nullptr;
+    m_clearProgram = nullptr;
+    m_basicProgram = nullptr;
+    m_instancedProgram = nullptr;
+    m_cubeVao = 0;
+    tileTex = nullptr;
+}
+
+void SegmentRenderer::resize(int w, int h) {
+    m_width = std::max(1, w);
+    m_height = std::max(1, h);
+
+    glViewport(0, 0, w, h);  // Set the viewport to the window size
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    updateProjectionMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+void SegmentRenderer::updateProjectionMatrix() {
+    float aspect = float(m_width) / float(m_height);
+    m_projectionMatrix = glm::perspective(glm::radians(m_camera.fov), aspect, 0.1f, 1000.0f);
+}
+
+QMatrix4x4 SegmentRenderer::getMVP(const QMatrix4x4& model, const RenderCamera& camera) const {
+    QMatrix4x4 projection;
+    projection.perspective(camera.fov, float(m_width) / float(m_height), 0.1f, 1000.0f);
+
+    QMatrix4x4 view;
+    QVector3D front;
+    front.setX(-cosf(qDegreesToRadians(camera.yaw)) * cosf(qDegreesToRadians(camera.pitch)));
+    front.setY(-sinf(qDegreesToRadians(camera.pitch)));
+    front.setZ(-sinf(qDegreesToRadians(camera.yaw)) * cosf(qDegreesToRadians(camera.pitch)));
+    front.setZ(-front.z());
+    front.normalize();
+
+    QVector3D cameraTarget = camera.position - front;
+    QVector3D up(0.0f, 1.0f, 0.0f);
+
+    if (camera.gameView) {
+        QVector3D eye(0, 0, -camera.gameViewPosition); // Camera moves along Z
+        QVector3D target = eye + QVector3D(0, 0, -1); // Look forward (toward -Z)
+        view.lookAt(eye, target, up);
+    } else {
+        view.lookAt(camera.position, cameraTarget, up);
+    }
+
+    return projection * view * model;
+}
+
+QOpenGLTexture* SegmentRenderer::loadTexture(QString filename) {
+    QImage image(filename);
+
+    qDebug() << "Loaded texture from image:" << filename;
+
+    if (!QOpenGLContext::currentContext() || !QOpenGLContext::currentContext()->isValid()) {
+        qWarning() << "OpenGL context is not valid!";
+    } else {
+        qWarning() << "OpenGL context is valid.";
+    }
+
+    int tile = 25;
+
+    int tilesPerRow = 8;
+    int tileWidth = 128;
+    int tileHeight = 128;
+
+    int col = tile % tilesPerRow;
+
+    int row = tile / tilesPerRow;
+
+    QRect tileRect(col * tileWidth, row * tileHeight, 64, 64);
+
+    QImage newTile = image.copy(tileRect);
+
+    if (newTile.isNull()) {
+        qWarning() << "Failed to copy tile from image:" << filename;
+        return nullptr;
+    }
+
+    tileTex = new QOpenGLTexture(newTile.mirrored());
+
+    tileTex->setMinificationFilter(QOpenGLTexture::Nearest);
+
+    return tileTex;
+
+}
+
+void SegmentRenderer::loadTileTexture() {
+
+    if (!QFile("tiles.jpg").exists()) extractMTXFile(m_rootDir + "/gfx/tiles.png.mtx");
+
+    tileTex = loadTexture("tiles.jpg");
+
+}
+
+void SegmentRenderer::render(const SceneStore& store, const Selection& selection,
+                             const RenderCamera& camera, const RenderOptions& options) {
+    const BoxArrays& boxes = store.boxes();
+
+    m_camera = camera;
+    m_options = options;
+
+    updateProjectionMatrix();
+
+    m_profiler.beginSection(FrameProfiler::ClearPass);
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glClearColor(0.0, 0.0, 0.0, 1.0);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glClearDepth(1.0);
+    glDepthMask(GL_TRUE); // Ensure depth writing
+
+    glEnable(GL_TEXTURE_2D);
+    //glLoadIdentity();
+    glLoadMatrixf(glm::value_ptr(m_projectionMatrix));
+
+    if (m_options.useShader) {
+
+        m_model = QMatrix4x4();
+
+        if (m_camera.gameView) m_model.translate(0, -1, m_camera.gameViewPosition);
+        else m_model.translate(-m_camera.position.x(), -m_camera.position.y(), -m_camera.position.z());
+
+        //model.rotate(m_camera.yaw)
+        //m_model.scale(1.0f, 1.0f, 1.0f);
+
+        //getCameraFront()
+
+        // Setup uniforms:
+        QMatrix4x4 mvp = getMVP(m_model, m_camera);
+
+        // === Render Fog (Clear Pass) ===
+        m_clearProgram->bind();
+        m_clearProgram->setUniformValue("uMvpMatrix", mvp);
+        m_clearProgram->setUniformValue("uLowerFog", QVector4D(m_options.lowerFogColour[0], m_options.lowerFogColour[1], m_options.lowerFogColour[2], m_options.lowerFogColour[3]));
+        m_clearProgram->setUniformValue("uUpperFog", QVector4D(m_options.upperFogColour[0], m_options.upperFogColour[1], m_options.upperFogColour[2], m_options.upperFogColour[3]));
+
+        glDisable(GL_DEPTH_TEST);
+        glDepthMask(GL_FALSE);
+
+        // Fullscreen quad setup
+        float fullscreenQuad[] = { -1.f, -1.f, 1.f, -1.f, 1.f, 1.f, -1.f, 1.f };
+        GLuint vbo;
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(fullscreenQuad), fullscreenQuad, GL_STATIC_DRAW);
+
+        int posAttrib = m_clearProgram->attributeLocation("aPosition");
+        glEnableVertexAttribArray(posAttrib);
+        glVertexAttribPointer(posAttrib, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+        m_profiler.addDrawCall(2);
+
+        glDisableVertexAttribArray(posAttrib);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDeleteBuffers(1, &vbo);
+
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_TEXTURE_2D);
+        glDepthMask(GL_TRUE);
+
+        // === Basic Pass ===
+        m_basicProgram->bind();
+
+        QVector2D texCoords[] = {
+            QVector2D(0.0f, 0.0f), // bottom-left
+            QVector2D(1.0f, 0.0f), // bottom-right
+            QVector2D(0.0f, 1.0f), // top-left
+            QVector2D(1.0f, 1.0f)  // top-right
+        };
+
+        int texCoordLocation = m_basicProgram->attributeLocation("aTexCoord");
+        m_basicProgram->enableAttributeArray(texCoordLocation);
+        m_basicProgram->setAttributeArray(texCoordLocation, GL_FLOAT, texCoords, 2);
+
+        QVector4D color = QVector4D(1.0, 0.0, 1.0, 1.0);
+
+        int colorLoc = m_basicProgram->attributeLocation("aColor");
+        m_basicProgram->enableAttributeArray(colorLoc);
+        m_basicProgram->setAttributeArray(colorLoc, &color);
+
+        QVector3D vertices[] = {
+            {-1, -1, 0}, {1, -1, 0}, {-1, 1, 0}, {1, 1, 1}
+        };
+
+        int posLoc = m_basicProgram->attributeLocation("aPosition");
+        m_basicProgram->enableAttributeArray(posLoc);
+        m_basicProgram->setAttributeArray(posLoc, GL_FLOAT, vertices, 3);
+
+        // === Room Pass ===
+        //m_roomProgram->bind();
+
+        //tileTex->bind();
+
+        //m_roomProgram->setUniformValue("uMvpMatrix", mvp);
+        //m_roomProgram->setUniformValue("uColor", QVector4D(1, 1, 1, 1)); // White
+        //m_roomProgram->setUniformValue("uLowerFog", QVector4D(m_options.lowerFogColour[0], m_options.lowerFogColour[1], m_options.lowerFogColour[2], m_options.lowerFogColour[3]));
+        //m_roomProgram->setUniformValue("uUpperFog", QVector4D(m_options.upperFogColour[0], m_options.upperFogColour[1], m_options.upperFogColour[2], m_options.upperFogColour[3]));
+        //m_roomProgram->setUniformValue("uTexture0", 0);
+
+    } else {
+        if (m_camera.gameView) {
+            glRotatef(0.0f,  1.0f, 0.0f, 0.0f);
+            glRotatef(0.0f,   0.0f, 1.0f, 0.0f);
+            glTranslatef(0.0f, -1.0f, m_camera.gameViewPosition);
+        } else {
+            // Apply rotation first
+            glRotatef(-m_camera.pitch, 1.0f, 0.0f, 0.0f);  // Pitch (X axis)
+            glRotatef(-m_camera.yaw,   0.0f, 1.0f, 0.0f);  // Yaw (Y axis)
+
+            // Then move the scene inversely to simulate camera movement
+            glTranslatef(-m_camera.position.x(), -m_camera.position.y(), -m_camera.position.z());
+        }
+    }
+
+    m_profiler.endSection(FrameProfiler::ClearPass);
+
+    m_model = QMatrix4x4();
+
+    m_model.translate(-m_camera.position.x(), -m_camera.position.y(), -m_camera.position.z());
+    m_model.rotate(-m_camera.pitch, 1.0f, 0.0f, 0.0f);
+    m_model.rotate(-m_camera.pitch, 1.0f, 0.0f, 0.0f);
+
+    QMatrix4x4 mvp = getMVP(m_model, m_camera);
+
+    // Same transform drawCubesInstanced uses, only the shader path can be culled against it
+    QMatrix4x4 cullModel;
+    if (m_camera.gameView) cullModel.translate(0, -1, m_camera.gameViewPosition);
+    else cullModel.translate(-m_camera.position.x(), -m_camera.position.y(), -m_camera.position.z());
+    QMatrix4x4 cullMvp = getMVP(cullModel, m_camera);
+
+    if (m_options.drawFaces) {
+        m_profiler.beginSection(FrameProfiler::BoxPass);
+
+        if (m_options.useShader) {
+            m_buffers->sync(this, store);
+
+            // Culling only picks which runs of the shared instance buffer get drawn
+            m_visibleIds.clear();
+            for (size_t i = 0; i < boxes.size(); ++i) {
+                if (isCubeVisible(boxes.position(i), boxes.halfSize(i), cullMvp)) m_visibleIds.push_back(static_cast<int>(i));
+            }
+            m_profiler.addCulled(static_cast<int>(boxes.size() - m_visibleIds.size()));
+
+            drawCubesInstanced();
+        } else {
+            // Draw filled cubes
+            for (size_t i = 0; i < boxes.size(); ++i) {
+                drawCube(boxes.box(i), boxes.isSelected(i));
+
+                m_profiler.addDrawCall(12);
+            }
+        }
+
+        m_profiler.endSection(FrameProfiler::BoxPass);
+    }
+
+    m_profiler.beginSection(FrameProfiler::OutlinePass);
+
+    if (m_options.drawFaces) {
+        // Highlight the selection on top of the filled cubes
+        for (BoxHandle handle : selection.items()) {
+            if (std::optional<Rect3D> cube = store.find(handle)) {
+                drawCubeOutline(*cube);
+                m_profiler.addDrawCall(0);
+            }
+        }
+    }
+
+    if (m_options.drawWireframe) {
+        // Now draw outlines for the cubes
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            drawCubeOutline(boxes.box(i)); // Draw only the outlines
+            m_profiler.addDrawCall(0);
+        }
+    }
+
+    m_profiler.endSection(FrameProfiler::OutlinePass);
+
+    if (m_options.drawDebugRay) {
+        m_profiler.beginSection(FrameProfiler::DebugRayPass);
+        drawDebugRay();
+        m_profiler.endSection(FrameProfiler::DebugRayPass);
+    }
+
+}
+
+void SegmentRenderer::endScene() {
+    glUseProgram(0); // Unbind any shader program
+    glDisable(GL_TEXTURE_2D); // Disable texture mapping for text rendering
+    glDisable(GL_DEPTH_TEST); // Disable depth testing for 2D text rendering
+}
+
+bool SegmentRenderer::isCubeVisible(const QVector3D& center, const QVector3D& halfSize, const QMatrix4x4& mvp) const {
+    // Cubes are drawn as position +/- size, so test all 8 corners in clip space.
+    // The cube is only rejected when every corner is outside the same plane.
+    int outside[6] = {0, 0, 0, 0, 0, 0};
+
+    for (int i = 0; i < 8; ++i) {
+        QVector4D corner(center.x() + ((i & 1) ? halfSize.x() : -halfSize.x()),
+                         center.y() + ((i & 2) ? halfSize.y() : -halfSize.y()),
+                         center.z() + ((i & 4) ? halfSize.z() : -halfSize.z()),
+                         1.0f);
+
+        QVector4D clip = mvp * corner;
+
+        if (clip.x() < -clip.w()) outside[0]++;
+        if (clip.x() >  clip.w()) outside[1]++;
+        if (clip.y() < -clip.w()) outside[2]++;
+        if (clip.y() >  clip.w()) outside[3]++;
+        if (clip.z() < -clip.w()) outside[4]++;
+        if (clip.z() >  clip.w()) outside[5]++;
+    }
+
+    for (int plane = 0; plane < 6; ++plane) {
+        if (outside[plane] == 8) return false;
+    }
+
+    return true;
+}
+
+void SegmentRenderer::drawDebugRay() {
+    if (!m_options.drawDebugRay) return;
+
+    // Save current state
+    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+
+    // Draw thick yellow line
+    glLineWidth(3.0f);
+    glColor3f(1.0f, 1.0f, 0.0f);
+
+    glBegin(GL_LINES);
+    glVertex3f(m_debugRayStart.x, m_debugRayStart.y, m_debugRayStart.z);
+    glVertex3f(m_debugRayEnd.x, m_debugRayEnd.y, m_debugRayEnd.z);
+    glEnd();
+
+    // Draw small marker at end
+    glPointSize(5.0f);
+    glBegin(GL_POINTS);
+    glVertex3f(m_debugRayEnd.x, m_debugRayEnd.y, m_debugRayEnd.z);
+    glEnd();
+
+    // Restore state
+    glPopAttrib();
+}
+
+QOpenGLShaderProgram *SegmentRenderer::createShaderProgram(const QString& name) {
+    QOpenGLShaderProgram *program = new QOpenGLShaderProgram();
+
+    QString vertPath = QString(":/res/shaders/%1.vert").arg(name);
+    QString fragPath = QString(":/res/shaders/%1.frag").arg(name);
+
+    if (!program->addShaderFromSourceFile(QOpenGLShader::Vertex, vertPath))
+        qWarning() << "Vertex shader failed:" << program->log();
+
+    if (!program->addShaderFromSourceFile(QOpenGLShader::Fragment, fragPath))
+        qWarning() << "Fragment shader failed:" << program->log();
+
+    if (!program->link())
+        qWarning() << "Shader linking failed:" << program->log();
+
+    return program;
+}
+
+void SegmentRenderer::drawCubesInstanced() {
+    if (m_visibleIds.empty()) return;
+
+    m_model = QMatrix4x4();
+
+    if (m_camera.gameView) m_model.translate(0, -1, m_camera.gameViewPosition);
+    else m_model.translate(-m_camera.position.x(), -m_camera.position.y(), -m_camera.position.z());
+
+    QMatrix4x4 mvp = getMVP(m_model, m_camera);
+
+    m_instancedProgram->bind();
+    m_instancedProgram->setUniformValue("uMvpMatrix", mvp);
+    m_instancedProgram->setUniformValue("uLowerFog", QVector4D(m_options.lowerFogColour[0], m_options.lowerFogColour[1], m_options.lowerFogColour[2], m_options.lowerFogColour[3]));
+    m_instancedProgram->setUniformValue("uUpperFog", QVector4D(m_options.upperFogColour[0], m_options.upperFogColour[1], m_options.upperFogColour[2], m_options.upperFogColour[3]));
+    m_instancedProgram->setUniformValue("uTexture0", 0);
+    m_buffers->setDecodeUniforms(this, m_instancedProgram);
+
+    glActiveTexture(GL_TEXTURE0);
+    tileTex->bind();
+
+    glBindVertexArray(m_cubeVao);
+
+    GLint position = m_instancedProgram->attributeLocation("aPosition");
+    GLint texCoord = m_instancedProgram->attributeLocation("aTexCoord");
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffers->cubeBuffer());
+    glEnableVertexAttribArray(position);
+    glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), nullptr);
+    glEnableVertexAttribArray(texCoord);
+    glVertexAttribPointer(texCoord, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), reinterpret_cast<const void*>(3 * sizeof(GLfloat)));
+
+    SceneBuffers::InstanceAttributes attributes = SceneBuffers::locate(m_instancedProgram);
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+    glFrontFace(GL_CCW);
+
+    SceneBuffers::forEachRun(m_visibleIds, [&](size_t first, size_t count) {
+        m_buffers->bindInstances(this, attributes, first);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(count));
+        m_profiler.addDrawCall(12 * static_cast<int>(count));
+    });
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SegmentRenderer::drawCube(const Rect3D& cubeRect, bool selected) {
+    float x0 = cubeRect.x() - cubeRect.width();
+    float x1 = cubeRect.x() + cubeRect.width();
+    float y0 = cubeRect.y() - cubeRect.height();
+    float y1 = cubeRect.y() + cubeRect.height();
+    float z0 = cubeRect.z() - cubeRect.depth();
+    float z1 = cubeRect.z() + cubeRect.depth();
+
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(1.0, 1.0);
+
+    glBegin(GL_QUADS);
+
+    if (!selected) {
+
+        if (m_options.drawColour) {
+
+            auto colour = cubeRect.getColour();
+
+            glColor3f(colour[0], colour[1], colour[2]);
+
+            glVertex3f(x0, y0, z1); glVertex3f(x1, y0, z1); glVertex3f(x1, y1, z1); glVertex3f(x0, y1, z1);
+            glVertex3f(x1, y0, z0); glVertex3f(x0, y0, z0); glVertex3f(x0, y1, z0); glVertex3f(x1, y1, z0);
+            glVertex3f(x0, y0, z0); glVertex3f(x0, y0, z1); glVertex3f(x0, y1, z1); glVertex3f(x0, y1, z0);
+            glVertex3f(x1, y0, z1); glVertex3f(x1, y0, z0); glVertex3f(x1, y1, z0); glVertex3f(x1, y1, z1);
+            glVertex3f(x0, y1, z1); glVertex3f(x1, y1, z1); glVertex3f(x1, y1, z0); glVertex3f(x0, y1, z0);
+            glVertex3f(x0, y0, z0); glVertex3f(x1, y0, z0); glVertex3f(x1, y0, z1); glVertex3f(x0, y0, z1);
+        } else {
+            glColor3f(1, 0, 0); glVertex3f(x0, y0, z1); glVertex3f(x1, y0, z1); glVertex3f(x1, y1, z1); glVertex3f(x0, y1, z1);
+            glColor3f(0, 1, 0); glVertex3f(x1, y0, z0); glVertex3f(x0, y0, z0); glVertex3f(x0, y1, z0); glVertex3f(x1, y1, z0);
+            glColor3f(0, 0, 1); glVertex3f(x0, y0, z0); glVertex3f(x0, y0, z1); glVertex3f(x0, y1, z1); glVertex3f(x0, y1, z0);
+            glColor3f(1, 1, 0); glVertex3f(x1, y0, z1); glVertex3f(x1, y0, z0); glVertex3f(x1, y1, z0); glVertex3f(x1, y1, z1);
+            glColor3f(1, 0, 1); glVertex3f(x0, y1, z1); glVertex3f(x1, y1, z1); glVertex3f(x1, y1, z0); glVertex3f(x0, y1, z0);
+            glColor3f(0, 1, 1); glVertex3f(x0, y0, z0); glVertex3f(x1, y0, z0); glVertex3f(x1, y0, z1); glVertex3f(x0, y0, z1);
+        }
+
+    } else {
+        glColor3f(1.0, 0.0, 0.0);
+
+        glVertex3f(x0, y0, z1); glVertex3f(x1, y0, z1); glVertex3f(x1, y1, z1); glVertex3f(x0, y1, z1);
+        glVertex3f(x1, y0, z0); glVertex3f(x0, y0, z0); glVertex3f(x0, y1, z0); glVertex3f(x1, y1, z0);
+        glVertex3f(x0, y0, z0); glVertex3f(x0, y0, z1); glVertex3f(x0, y1, z1); glVertex3f(x0, y1, z0);
+        glVertex3f(x1, y0, z1); glVertex3f(x1, y0, z0); glVertex3f(x1, y1, z0); glVertex3f(x1, y1, z1);
+        glVertex3f(x0, y1, z1); glVertex3f(x1, y1, z1); glVertex3f(x1, y1, z0); glVertex3f(x0, y1, z0);
+        glVertex3f(x0, y0, z0); glVertex3f(x1, y0, z0); glVertex3f(x1, y0, z1); glVertex3f(x0, y0, z1);
+    }
+
+    glEnd();
+    glDisable(GL_POLYGON_OFFSET_FILL);
+
+    // Draw grid lines (if m_options.drawColour is true)
+    if (m_options.drawColour) {
+
+        auto colour = cubeRect.getColour();
+        glColor3f(
+            colour[0] * 0.7f,
+            colour[1] * 0.7f,
+            colour[2] * 0.7f
+            );
+
+        glLineWidth(2.0f);  // <-- Make the grid lines thicker (default is 1.0)
+
+        glBegin(GL_LINES);
+
+        // Grid on Front and Back faces (XY plane at Z = z1 and Z = z0)
+        for (float x = std::ceil(x0); x <= x1; x += 1.0f) {
+            glVertex3f(x, y0, z1); glVertex3f(x, y1, z1);  // Front
+            glVertex3f(x, y0, z0); glVertex3f(x, y1, z0);  // Back
+        }
+        for (float y = std::ceil(y0); y <= y1; y += 1.0f) {
+            glVertex3f(x0, y, z1); glVertex3f(x1, y, z1);  // Front
+            glVertex3f(x0, y, z0); glVertex3f(x1, y, z0);  // Back
+        }
+
+        // Grid on Left and Right faces (YZ plane at X = x0 and X = x1)
+        for (float y = std::ceil(y0); y <= y1; y += 1.0f) {
+            glVertex3f(x0, y, z0); glVertex3f(x0, y, z1);  // Left
+            glVertex3f(x1, y, z0); glVertex3f(x1, y, z1);  // Right
+        }
+        for (float z = std::ceil(z0); z <= z1; z += 1.0f) {
+            glVertex3f(x0, y0, z); glVertex3f(x0, y1, z);  // Left
+            glVertex3f(x1, y0, z); glVertex3f(x1, y1, z);  // Right
+        }
+
+        // Grid on Top and Bottom faces (XZ plane at Y = y1 and Y = y0)
+        for (float x = std::ceil(x0); x <= x1; x += 1.0f) {
+            glVertex3f(x, y1, z0); glVertex3f(x, y1, z1);  // Top
+            glVertex3f(x, y0, z0); glVertex3f(x, y0, z1);  // Bottom
+        }
+        for (float z = std::ceil(z0); z <= z1; z += 1.0f) {
+            glVertex3f(x0, y1, z); glVertex3f(x1, y1, z);  // Top
+            glVertex3f(x0, y0, z); glVertex3f(x1, y0, z);  // Bottom
+        }
+
+        glEnd();
+    }
+}
+
+
+void SegmentRenderer::drawCubeOutline(const Rect3D& cubeRect) {
+    float x0 = cubeRect.x() - cubeRect.width();
+    float x1 = cubeRect.x() + cubeRect.width();
+    float y0 = cubeRect.y() - cubeRect.height();
+    float y1 = cubeRect.y() + cubeRect.height();
+    float z0 = cubeRect.z() - cubeRect.depth();
+    float z1 = cubeRect.z() + cubeRect.depth();
+
+    glLineWidth(1.0f);
+
+    // Set line color for the outline
+    glBegin(GL_LINES);
+
+    glColor3f(1.0f, 1.0, 0.0f); // Yellow for the outline
+
+    // Front face edges
+    glVertex3f(x0, y0, z1); glVertex3f(x1, y0, z1);
+    glVertex3f(x1, y0, z1); glVertex3f(x1, y1, z1);
+    glVertex3f(x1, y1, z1); glVertex3f(x0, y1, z1);
+    glVertex3f(x0, y1, z1); glVertex3f(x0, y0, z1);
+
+    // Back face edges
+    glVertex3f(x0, y0, z0); glVertex3f(x1, y0, z0);
+    glVertex3f(x1, y0, z0); glVertex3f(x1, y1, z0);
+    glVertex3f(x1, y1, z0); glVertex3f(x0, y1, z0);
+    glVertex3f(x0, y1, z0); glVertex3f(x0, y0, z0);
+
+    // Connecting edges between front and back faces
+    glVertex3f(x0, y0, z0); glVertex3f(x0, y0, z1);
+    glVertex3f(x1, y0, z0); glVertex3f(x1, y0, z1);
+    glVertex3f(x0, y1, z0); glVertex3f(x0, y1, z1);
+    glVertex3f(x1, y1, z0); glVertex3f(x1, y1, z1);
+
+    glEnd();
+}
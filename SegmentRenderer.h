@@ -0,0 +1,132 @@
+#ifndef SEGMENTRENDERER_H
+#define SEGMENTRENDERER_H
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "Rect3D.h"
+#include "FrameProfiler.h"
+#include "SceneBuffers.h"
+#include "Selection.h"
+
+inline glm::vec3 toVec3(QVector3D vec) {
+    return glm::vec3(vec.x(), vec.y(), vec.z());
+}
+
+// Everything the renderer needs to know about where the scene is viewed from
+struct RenderCamera {
+    QVector3D position = QVector3D(0.0f, 0.0f, 0.0f);
+    float yaw = 0.0f;
+    float pitch = 0.0f;
+    float fov = 70.0f;
+    bool gameView = false;
+    float gameViewPosition = 1.0f;
+
+    // Game view only travels along the level, W/S in the 3D view and the benchmark path both go through here
+    void advanceGameView(float distance) { gameViewPosition += distance; }
+};
+
+struct RenderOptions {
+    bool drawFaces = true;
+    bool drawWireframe = false;
+    bool drawColour = true;
+    bool useShader = true;
+    bool drawDebugRay = true;
+
+    std::array<float, 4> lowerFogColour = {0.4f, 0.0f, 0.5f, 1.0f};
+    std::array<float, 4> upperFogColour = {1.3f, 0.9f, 0.6f, 1.0f};
+};
+
+// Draws boxes into whatever framebuffer is bound on the current context.
+// Used by SegmentWidget on screen and by OffscreenRenderer for thumbnails and benchmarks.
+class SegmentRenderer : protected QOpenGLFunctions_3_3_Core {
+public:
+    SegmentRenderer() = default;
+
+    // Must be called with the target context current
+    void initialize(const QString& rootDir);
+    void release();
+
+    void resize(int w, int h);
+
+    void render(const SceneStore& store, const Selection& selection,
+                const RenderCamera& camera, const RenderOptions& options);
+
+    // Leaves the context in a state QPainter can draw on top of
+    void endScene();
+
+    QMatrix4x4 getMVP(const QMatrix4x4& model, const RenderCamera& camera) const;
+
+    const glm::mat4& projectionMatrix() const { return m_projectionMatrix; }
+    const QMatrix4x4& model() const { return m_model; }
+
+    void setDebugRay(const glm::vec3& start, const glm::vec3& end) {
+        m_debugRayStart = start;
+        m_debugRayEnd = end;
+    }
+
+    FrameProfiler& profiler() { return m_profiler; }
+
+    // Loads :/res/shaders/<name>.vert and .frag into a linked program, on the current context
+    static QOpenGLShaderProgram *createShaderProgram(const QString& name);
+
+    // Draw from buffers shared with other views instead of the renderer's own. Set before initialize().
+    void setSceneBuffers(SceneBuffers *buffers) { m_buffers = buffers; }
+    SceneBuffers& sceneBuffers() { return *m_buffers; }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+private:
+    int m_width = 1;
+    int m_height = 1;
+
+    QString m_rootDir;
+
+    glm::mat4 m_projectionMatrix = glm::mat4(1.0f);
+    QMatrix4x4 m_model;
+
+    RenderCamera m_camera;
+    RenderOptions m_options;
+
+    glm::vec3 m_debugRayStart = glm::vec3(0.0f);
+    glm::vec3 m_debugRayEnd = glm::vec3(0.0f);
+
+    FrameProfiler m_profiler;
+
+    QOpenGLTexture *tileTex = nullptr;
+
+    // Fog shader stuff
+    QOpenGLShaderProgram *m_roomProgram = nullptr;
+    QOpenGLShaderProgram *m_clearProgram = nullptr;
+    QOpenGLShaderProgram *m_basicProgram = nullptr;
+    QOpenGLShaderProgram *m_instancedProgram = nullptr;
+
+    SceneBuffers m_ownBuffers;
+    SceneBuffers *m_buffers = &m_ownBuffers;
+    GLuint m_cubeVao = 0;
+    std::vector<int> m_visibleIds;
+
+    QOpenGLTexture *loadTexture(QString filename);
+    void loadTileTexture();
+
+    void updateProjectionMatrix();
+
+    void drawDebugRay();
+
+    // Every box in m_visibleIds, one instanced draw per run of consecutive boxes
+    void drawCubesInstanced();
+
+    void drawCube(const Rect3D& cubeRect, bool selected = false);
+
+    void drawCubeOutline(const Rect3D& cubeRect);
+
+    bool isCubeVisible(const QVector3D& center, const QVector3D& halfSize, const QMatrix4x4& mvp) const;
+};
+
+#endif // SEGMENTRENDERER_H
@@ -1,370 +1,199 @@
 #include "SegmentWidget.h"
 #include "MainWindow.h"
-#include "TextureLoader.h"
-#include "TextureExtractor.h"
+#include "BoxRaycast.h"
 #include <GL/glu.h>
 
-// Template function to check if a value is in the container
-template <typename T, typename U>
-bool contains(const T& container, const U& value) {
-    return std::find(container->begin(), container->end(), value) != container->end();
-}
-
 float roundToNearest005(float value) {
     return std::round(value / 0.05f) * 0.05f;
 }
 
-glm::vec3 toVec3(QVector3D vec) {
-    return glm::vec3(vec.x(), vec.y(), vec.z());
+// Rotation is taken from the newest state so mouse look never lags behind by a tick
+static RenderCamera interpolateCamera(const RenderCamera& previous, const RenderCamera& current, float alpha) {
+    RenderCamera camera = current;
+    camera.position = previous.position + (current.position - previous.position) * alpha;
+    camera.gameViewPosition = previous.gameViewPosition + (current.gameViewPosition - previous.gameViewPosition) * alpha;
+    return camera;
 }
 
-SegmentWidget::SegmentWidget(QWidget *parent, std::vector<Rect3D> *rects, std::vector<Rect3D*> *selectedRects) : QOpenGLWidget(parent), m_drawWireframe(false), m_drawFaces(true), m_gameView(false), m_drawColour(true), m_cameraPosition(0.0f, 0.0f, 0.0f),
-    m_cameraYaw(0.0f), m_cameraPitch(0.0f), m_gameViewPosition(1.0f), m_isDragging(false), m_parent(parent), m_useShader(true), m_selectedRects(selectedRects), m_rects(rects) {
+SegmentWidget::SegmentWidget(QWidget *parent, SceneStore *store, Selection *selection) : QOpenGLWidget(parent), m_drawWireframe(false), m_drawFaces(true), m_gameView(false), m_drawColour(true),
+    m_isDragging(false), m_parent(parent), m_useShader(true), m_selection(selection), m_store(store) {
     m_cameraSpeed = 0.1f;
     m_mouseSensitivity = 1.0f;  // Adjust this for faster/slower rotation
     setFocusPolicy(Qt::StrongFocus);
 
-    QTimer *timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, this, QOverload<>::of(&SegmentWidget::update));
-    timer->start(4); // ~250 FPS (1000ms / 250 ≈ 4ms)
-
-    if (m_rects != nullptr) {
-        m_rects->push_back(Rect3D(0.0f, 0.0f, 0.0f, 10.0f, 10.0f, 10.0f));
+    if (m_store != nullptr) {
+        m_store->insert(Rect3D(0.0f, 0.0f, 0.0f, 10.0f, 10.0f, 10.0f));
     }
 
     m_glToggle = true;
-    m_cameraFov = 70.0f;
 
     //m_roomProgram = createShaderProgram("room");
 
 }
 
-QOpenGLTexture* SegmentWidget::loadTexture(QString filename) {
-    QImage image(filename);
-
-    qDebug() << "Loaded texture from image:" << filename;
-
-    if (!context()->isValid()) {
-        qWarning() << "OpenGL context is not valid!";
-    } else {
-        qWarning() << "OpenGL context is valid.";
-    }
-
-    int tile = 25;
-
-    int tilesPerRow = 8;
-    int tileWidth = 128;
-    int tileHeight = 128;
-
-    int col = tile % tilesPerRow;
-
-    int row = tile / tilesPerRow;
-
-    QRect tileRect(col * tileWidth, row * tileHeight, 64, 64);
-
-    QImage newTile = image.copy(tileRect);
-
-    if (newTile.isNull()) {
-        qWarning() << "Failed to copy tile from image:" << filename;
-        return nullptr;
-    }
+void SegmentWidget::setRootDir(QString rootDir) {
+    m_rootDir = rootDir;
+}
 
-    tileTex = new QOpenGLTexture(newTile.mirrored());
+void SegmentWidget::setFov(int value) {
+    m_camera.fov = value;
 
-    tileTex->setMinificationFilter(QOpenGLTexture::Nearest);
+    requestRepaint();
 
-    return tileTex;
+}
 
+void SegmentWidget::requestRepaint() {
+    if (m_scheduler) m_scheduler->request(this);
+    else update();
 }
 
-void SegmentWidget::loadTileTexture() {
+bool SegmentWidget::isAnimating() const {
+    static const int movementKeys[] = {Qt::Key_W, Qt::Key_A, Qt::Key_S, Qt::Key_D, Qt::Key_Q, Qt::Key_E, Qt::Key_Control, Qt::Key_Shift};
 
-    if (!QFile("tiles.jpg").exists()) extractMTXFile(m_rootDir + "/gfx/tiles.png.mtx");
+    // The profiler graph is only meaningful while frames keep coming
+    if (m_renderer.profiler().isEnabled()) return true;
 
-    tileTex = loadTexture("tiles.jpg");
+    if (!hasFocus()) return false;
 
+    for (int key : movementKeys) {
+        if (m_pressedKeys.contains(key)) return true;
+    }
+    return false;
 }
 
-void SegmentWidget::setRootDir(QString rootDir) {
-    m_rootDir = rootDir;
+void SegmentWidget::setSens(float value) {
+    m_mouseSensitivity = value;
 }
 
-void SegmentWidget::setFov(int value) {
-    m_cameraFov = value;
-
-    if (context()) resizeGL(width(), height());
-
+void SegmentWidget::setShowProfiler(bool show) {
+    m_renderer.profiler().setEnabled(show);
+    requestRepaint();
 }
 
-void SegmentWidget::setSens(float value) {
-    m_mouseSensitivity = value;
+SegmentWidget::~SegmentWidget() {
+    makeCurrent();
+    m_renderer.release();
+    doneCurrent();
 }
 
 void SegmentWidget::initializeGL() {
     initializeOpenGLFunctions();
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glFrontFace(GL_CCW);
-    glClearDepth(1.0);
-    glDepthMask(GL_TRUE); // Ensure depth writing
-
-    qDebug() << "Loading room program!";
-
-    m_roomProgram = createShaderProgram("room");
-
-    qDebug() << "Loading clear program!";
-    m_clearProgram = createShaderProgram("clear");
-    m_basicProgram = createShaderProgram("basic");
-
-    loadTileTexture();
+    m_renderer.initialize(m_rootDir);
 }
 
 void SegmentWidget::resizeGL(int w, int h) {
-    glViewport(0, 0, w, h);  // Set the viewport to the window size
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    projectionMatrix = glm::perspective(glm::radians(m_cameraFov),
-                                        (float)w/(float)h,
-                                        0.1f,  // Note: matches legacy far plane
-                                        1000.0f);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+    m_renderer.resize(w, h);
 }
 
 glm::mat4 SegmentWidget::getViewMatrix() {
-    glm::vec3 camPos = toVec3(m_cameraPosition);
+    glm::vec3 camPos = toVec3(m_camera.position);
     glm::vec3 camFront = glm::normalize(getCameraFront());
     glm::vec3 up(0, 1, 0);
     return glm::lookAt(camPos, camPos + camFront, up);
 }
 
-void SegmentWidget::updateProjectionMatrix() {
-    float aspect = float(width()) / std::max(1.0f, float(height()));
-    projectionMatrix = glm::perspective(glm::radians(m_cameraFov), aspect, 0.1f, 1000.0f);
+RenderCamera SegmentWidget::camera() const {
+    RenderCamera camera = interpolateCamera(m_previousCamera, m_camera, m_tickAlpha);
+    camera.gameView = m_gameView;
+    return camera;
 }
 
-QMatrix4x4 SegmentWidget::getMVP(const QMatrix4x4& model) {
-    QMatrix4x4 projection;
-    projection.perspective(m_cameraFov, float(width()) / float(height()), 0.1f, 1000.0f);
-
-    QMatrix4x4 view;
-    QVector3D front;
-    front.setX(-cosf(qDegreesToRadians(m_cameraYaw)) * cosf(qDegreesToRadians(m_cameraPitch)));
-    front.setY(-sinf(qDegreesToRadians(m_cameraPitch)));
-    front.setZ(-sinf(qDegreesToRadians(m_cameraYaw)) * cosf(qDegreesToRadians(m_cameraPitch)));
-    front.setZ(-front.z());
-    front.normalize();
-
-    QVector3D cameraTarget = m_cameraPosition - front;
-    QVector3D up(0.0f, 1.0f, 0.0f);
-
-    if (m_gameView) {
-        QVector3D eye(0, 0, -m_gameViewPosition); // Camera moves along Z
-        QVector3D target = eye + QVector3D(0, 0, -1); // Look forward (toward -Z)
-        view.lookAt(eye, target, up);
-    } else {
-        view.lookAt(m_cameraPosition, cameraTarget, up);
-    }
-
-    //qDebug() << view;
-
-    return projection * view * model;
+void SegmentWidget::snapCamera() {
+    m_previousCamera = m_camera;
 }
 
-void SegmentWidget::paintGL() {
-
-    QPainter painter(this);
-    painter.beginNativePainting();
-
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glClearColor(0.0, 0.0, 0.0, 1.0);
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glClearDepth(1.0);
-    glDepthMask(GL_TRUE); // Ensure depth writing
-
-    glEnable(GL_TEXTURE_2D);
-    //glLoadIdentity();
-    glLoadMatrixf(glm::value_ptr(projectionMatrix));
-
-    if (m_useShader) {
-
-        m_model = QMatrix4x4();
-
-        if (m_gameView) m_model.translate(0, -1, m_gameViewPosition);
-        else m_model.translate(-m_cameraPosition.x(), -m_cameraPosition.y(), -m_cameraPosition.z());
-
-        //model.rotate(m_cameraYaw)
-        //m_model.scale(1.0f, 1.0f, 1.0f);
-
-        //getCameraFront()
-
-        // Setup uniforms:
-        QMatrix4x4 mvp = getMVP(m_model);
-
-        // === Render Fog (Clear Pass) ===
-        m_clearProgram->bind();
-        m_clearProgram->setUniformValue("uMvpMatrix", mvp);
-        m_clearProgram->setUniformValue("uLowerFog", QVector4D(lowerFogColour[0], lowerFogColour[1], lowerFogColour[2], lowerFogColour[3]));
-        m_clearProgram->setUniformValue("uUpperFog", QVector4D(upperFogColour[0], upperFogColour[1], upperFogColour[2], upperFogColour[3]));
-
-        glDisable(GL_DEPTH_TEST);
-        glDepthMask(GL_FALSE);
-
-        // Fullscreen quad setup
-        float fullscreenQuad[] = { -1.f, -1.f, 1.f, -1.f, 1.f, 1.f, -1.f, 1.f };
-        GLuint vbo;
-        glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(fullscreenQuad), fullscreenQuad, GL_STATIC_DRAW);
-
-        int posAttrib = m_clearProgram->attributeLocation("aPosition");
-        glEnableVertexAttribArray(posAttrib);
-        glVertexAttribPointer(posAttrib, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-
-        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-
-        glDisableVertexAttribArray(posAttrib);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glDeleteBuffers(1, &vbo);
-
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_TEXTURE_2D);
-        glDepthMask(GL_TRUE);
-
-        // === Basic Pass ===
-        m_basicProgram->bind();
-
-        QVector2D texCoords[] = {
-            QVector2D(0.0f, 0.0f), // bottom-left
-            QVector2D(1.0f, 0.0f), // bottom-right
-            QVector2D(0.0f, 1.0f), // top-left
-            QVector2D(1.0f, 1.0f)  // top-right
-        };
-
-        int texCoordLocation = m_basicProgram->attributeLocation("aTexCoord");
-        m_basicProgram->enableAttributeArray(texCoordLocation);
-        m_basicProgram->setAttributeArray(texCoordLocation, GL_FLOAT, texCoords, 2);
-
-        QVector4D color = QVector4D(1.0, 0.0, 1.0, 1.0);
-
-        int colorLoc = m_basicProgram->attributeLocation("aColor");
-        m_basicProgram->enableAttributeArray(colorLoc);
-        m_basicProgram->setAttributeArray(colorLoc, &color);
-
-        QVector3D vertices[] = {
-            {-1, -1, 0}, {1, -1, 0}, {-1, 1, 0}, {1, 1, 1}
-        };
+void SegmentWidget::simulate() {
+    // Nothing moves between repaints when idle, so start the clock fresh instead of catching up
+    if (!isAnimating()) {
+        m_tickClock.invalidate();
+        m_tickAccumulator = 0.0;
+        m_tickAlpha = 1.0f;
+        snapCamera();
+        return;
+    }
 
-        int posLoc = m_basicProgram->attributeLocation("aPosition");
-        m_basicProgram->enableAttributeArray(posLoc);
-        m_basicProgram->setAttributeArray(posLoc, GL_FLOAT, vertices, 3);
+    if (!m_tickClock.isValid()) {
+        m_tickClock.start();
+        snapCamera();
+        return;
+    }
 
-        // === Room Pass ===
-        //m_roomProgram->bind();
+    m_tickAccumulator += m_tickClock.restart() / 1000.0;
 
-        //tileTex->bind();
+    // After a stall (window drag, breakpoint) drop the backlog instead of running hundreds of ticks
+    if (m_tickAccumulator > kMaxTickBacklog) m_tickAccumulator = kMaxTickBacklog;
 
-        //m_roomProgram->setUniformValue("uMvpMatrix", mvp);
-        //m_roomProgram->setUniformValue("uColor", QVector4D(1, 1, 1, 1)); // White
-        //m_roomProgram->setUniformValue("uLowerFog", QVector4D(lowerFogColour[0], lowerFogColour[1], lowerFogColour[2], lowerFogColour[3]));
-        //m_roomProgram->setUniformValue("uUpperFog", QVector4D(upperFogColour[0], upperFogColour[1], upperFogColour[2], upperFogColour[3]));
-        //m_roomProgram->setUniformValue("uTexture0", 0);
+    while (m_tickAccumulator >= kTickInterval) {
+        m_previousCamera = m_camera;
 
-    } else {
-        if (m_gameView) {
-            glRotatef(0.0f,  1.0f, 0.0f, 0.0f);
-            glRotatef(0.0f,   0.0f, 1.0f, 0.0f);
-            glTranslatef(0.0f, -1.0f, m_gameViewPosition);
-        } else {
-            // Apply rotation first
-            glRotatef(-m_cameraPitch, 1.0f, 0.0f, 0.0f);  // Pitch (X axis)
-            glRotatef(-m_cameraYaw,   0.0f, 1.0f, 0.0f);  // Yaw (Y axis)
+        if (hasFocus()) handleInput();
 
-            // Then move the scene inversely to simulate camera movement
-            glTranslatef(-m_cameraPosition.x(), -m_cameraPosition.y(), -m_cameraPosition.z());
+        if (m_recordingPath) {
+            RenderCamera recorded = m_camera;
+            recorded.gameView = m_gameView;
+            m_recordedPath.append(recorded);
         }
+
+        m_tickAccumulator -= kTickInterval;
     }
 
+    m_tickAlpha = static_cast<float>(m_tickAccumulator / kTickInterval);
+}
 
+RenderOptions SegmentWidget::renderOptions() const {
+    RenderOptions options;
+    options.drawFaces = m_drawFaces;
+    options.drawWireframe = m_drawWireframe;
+    options.drawColour = m_drawColour;
+    options.useShader = m_useShader;
+    options.drawDebugRay = m_drawDebugRay;
+    options.lowerFogColour = lowerFogColour;
+    options.upperFogColour = upperFogColour;
+    return options;
+}
 
-    m_model = QMatrix4x4();
+QMatrix4x4 SegmentWidget::getMVP(const QMatrix4x4& model) {
+    return m_renderer.getMVP(model, camera());
+}
 
-    m_model.translate(-m_cameraPosition.x(), -m_cameraPosition.y(), -m_cameraPosition.z());
-    m_model.rotate(-m_cameraPitch, 1.0f, 0.0f, 0.0f);
-    m_model.rotate(-m_cameraPitch, 1.0f, 0.0f, 0.0f);
+void SegmentWidget::paintGL() {
 
-    QMatrix4x4 mvp = getMVP(m_model);
+    FrameProfiler& profiler = m_renderer.profiler();
 
-    if (m_drawFaces) {
-        // Draw filled cubes
-        for (const Rect3D& cube : *m_rects) {
-            bool isSelected = contains(m_selectedRects, &cube); // Check if the pointer to cube is in the selected rects
-            if (m_useShader) drawCubeNew(cube, isSelected); // Draw filled cubes, depending on whether selected
-            else drawCube(cube, isSelected);
+    profiler.beginFrame();
 
-            if (isSelected) {
-                drawCubeOutline(cube);
-            }
-        }
-    }
+    // Advance the camera in fixed ticks first, then draw it interpolated between the last two
+    profiler.beginSection(FrameProfiler::InputPhase);
+    simulate();
+    profiler.endSection(FrameProfiler::InputPhase);
 
-    if (m_drawWireframe) {
-        // Now draw outlines for the cubes
-        for (const Rect3D& cube : *m_rects) {
-            drawCubeOutline(cube); // Draw only the outlines
-        }
-    }
+    QPainter painter(this);
+    painter.beginNativePainting();
 
-    if (m_drawDebugRay) {
-        drawDebugRay();
-    }
+    m_renderer.setDebugRay(m_debugRayStart, m_debugRayEnd);
+    m_renderer.render(*m_store, *m_selection, camera(), renderOptions());
 
     // Now draw text
 
-    glUseProgram(0); // Unbind any shader program
-    glDisable(GL_TEXTURE_2D); // Disable texture mapping for text rendering
-    glDisable(GL_DEPTH_TEST); // Disable depth testing for 2D text rendering
+    profiler.beginSection(FrameProfiler::TextPass);
+
+    m_renderer.endScene();
 
     painter.endNativePainting();
     painter.setPen(Qt::white);
     painter.setFont(QFont("Arial", 16));
     painter.drawText(10, 25, "3D View");
-    painter.end();
-
-    if (hasFocus()) handleInput();
-
-}
 
-void SegmentWidget::drawDebugRay() {
-    if (!m_drawDebugRay) return;
+    if (profiler.isEnabled()) profiler.drawOverlay(painter, rect());
 
-    // Save current state
-    glPushAttrib(GL_ALL_ATTRIB_BITS);
-    glDisable(GL_LIGHTING);
-    glDisable(GL_TEXTURE_2D);
+    painter.end();
 
-    // Draw thick yellow line
-    glLineWidth(3.0f);
-    glColor3f(1.0f, 1.0f, 0.0f);
+    profiler.endSection(FrameProfiler::TextPass);
 
-    glBegin(GL_LINES);
-    glVertex3f(m_debugRayStart.x, m_debugRayStart.y, m_debugRayStart.z);
-    glVertex3f(m_debugRayEnd.x, m_debugRayEnd.y, m_debugRayEnd.z);
-    glEnd();
+    profiler.endFrame();
 
-    // Draw small marker at end
-    glPointSize(5.0f);
-    glBegin(GL_POINTS);
-    glVertex3f(m_debugRayEnd.x, m_debugRayEnd.y, m_debugRayEnd.z);
-    glEnd();
+    if (isAnimating()) requestRepaint();
 
-    // Restore state
-    glPopAttrib();
 }
 
 void SegmentWidget::handleInput() {
@@ -372,7 +201,7 @@ void SegmentWidget::handleInput() {
     float rightSpeed = m_cameraSpeed;
 
     // Convert yaw to radians
-    float radYaw = qDegreesToRadians(m_cameraYaw);
+    float radYaw = qDegreesToRadians(m_camera.yaw);
 
     // Calculate the movement direction relative to the camera's yaw
     QVector3D forwardDirection(cos(radYaw), 0.0f, -sin(radYaw));  // Forward direction
@@ -380,13 +209,11 @@ void SegmentWidget::handleInput() {
 
     if (m_gameView) {
         if (m_pressedKeys.contains(Qt::Key_W)) {
-            m_gameViewPosition += m_cameraSpeed;  // Move forward
-            //qDebug() << "Moving to" << m_gameViewPosition;
+            m_camera.advanceGameView(m_cameraSpeed);  // Move forward
         }
 
         if (m_pressedKeys.contains(Qt::Key_S)) {
-            m_gameViewPosition -= m_cameraSpeed;  // Move backwards
-            //qDebug() << "Moving to" << m_gameViewPosition;
+            m_camera.advanceGameView(-m_cameraSpeed);  // Move backwards
         }
     } else {
 
@@ -394,9 +221,9 @@ void SegmentWidget::handleInput() {
 
             // Forward direction based on the camera yaw and pitch
             QVector3D front;
-            front.setX(-cosf(qDegreesToRadians(m_cameraYaw)) * cosf(qDegreesToRadians(m_cameraPitch)));
-            front.setY(-sinf(qDegreesToRadians(m_cameraPitch)));
-            front.setZ(-sinf(qDegreesToRadians(m_cameraYaw)) * cosf(qDegreesToRadians(m_cameraPitch)));
+            front.setX(-cosf(qDegreesToRadians(m_camera.yaw)) * cosf(qDegreesToRadians(m_camera.pitch)));
+            front.setY(-sinf(qDegreesToRadians(m_camera.pitch)));
+            front.setZ(-sinf(qDegreesToRadians(m_camera.yaw)) * cosf(qDegreesToRadians(m_camera.pitch)));
             front.setZ(-front.z());
             front.normalize();
 
@@ -405,110 +232,68 @@ void SegmentWidget::handleInput() {
 
             // Now move based on keys
             if (m_pressedKeys.contains(Qt::Key_W)) {
-                m_cameraPosition -= front * forwardSpeed;  // Move forward
+                m_camera.position -= front * forwardSpeed;  // Move forward
             }
 
             if (m_pressedKeys.contains(Qt::Key_S)) {
-                m_cameraPosition += front * forwardSpeed;  // Move backward
+                m_camera.position += front * forwardSpeed;  // Move backward
             }
 
             if (m_pressedKeys.contains(Qt::Key_A)) {
-                m_cameraPosition += rightDirection * rightSpeed;  // Move left
+                m_camera.position += rightDirection * rightSpeed;  // Move left
             }
 
             if (m_pressedKeys.contains(Qt::Key_D)) {
-                m_cameraPosition -= rightDirection * rightSpeed;  // Move right
+                m_camera.position -= rightDirection * rightSpeed;  // Move right
             }
 
         } else {
 
             if (m_pressedKeys.contains(Qt::Key_W)) {
-                m_cameraPosition -= rightDirection * rightSpeed;  // Move forward
+                m_camera.position -= rightDirection * rightSpeed;  // Move forward
             }
 
             if (m_pressedKeys.contains(Qt::Key_S)) {
-                m_cameraPosition += rightDirection * rightSpeed;  // Move backwards
+                m_camera.position += rightDirection * rightSpeed;  // Move backwards
             }
 
             if (m_pressedKeys.contains(Qt::Key_A)) {
-                m_cameraPosition -= forwardDirection * forwardSpeed;  // Move left
+                m_camera.position -= forwardDirection * forwardSpeed;  // Move left
             }
 
             if (m_pressedKeys.contains(Qt::Key_D)) {
-                m_cameraPosition += forwardDirection * forwardSpeed;  // Move right
+                m_camera.position += forwardDirection * forwardSpeed;  // Move right
             }
         }
 
         if (m_pressedKeys.contains(Qt::Key_Q) || m_pressedKeys.contains(Qt::Key_Control)) {
-            m_cameraPosition += QVector3D(0, -m_cameraSpeed, 0);   // Move down
+            m_camera.position += QVector3D(0, -m_cameraSpeed, 0);   // Move down
         }
         if (m_pressedKeys.contains(Qt::Key_E) || m_pressedKeys.contains(Qt::Key_Shift)) {
-            m_cameraPosition += QVector3D(0, m_cameraSpeed, 0);    // Move up
-        }
-    }
-}
-
-bool SegmentWidget::intersects(const glm::vec3& rayDir, const glm::vec3& rayOrigin, const Rect3D& cube) {
-    // Define the AABB bounds
-    glm::vec3 cubeMin(cube.x() - cube.width(),
-                      cube.y() - cube.height(),
-                      cube.z() - cube.depth());
-    glm::vec3 cubeMax(cube.x() + cube.width(),
-                      cube.y() + cube.height(),
-                      cube.z() + cube.depth());
-
-    // Initial t values (entire ray)
-    float tMin = 0.0f;
-    float tMax = std::numeric_limits<float>::max();
-
-    // Test each axis
-    for (int i = 0; i < 3; ++i) {
-        if (std::abs(rayDir[i]) < 1e-6) {
-            // Ray parallel to this axis - check if origin is outside bounds
-            if (rayOrigin[i] < cubeMin[i] || rayOrigin[i] > cubeMax[i]) {
-                return false;
-            }
-        } else {
-            // Compute intersection distances
-            float invDir = 1.0f / rayDir[i];
-            float t1 = (cubeMin[i] - rayOrigin[i]) * invDir;
-            float t2 = (cubeMax[i] - rayOrigin[i]) * invDir;
-
-            // Ensure t1 is the nearer intersection
-            if (t1 > t2) std::swap(t1, t2);
-
-            // Update global tMin and tMax
-            tMin = std::max(tMin, t1);
-            tMax = std::min(tMax, t2);
-
-            // Early exit if ray misses
-            if (tMin > tMax) return false;
+            m_camera.position += QVector3D(0, m_cameraSpeed, 0);    // Move up
         }
     }
-
-    // If we get here, there's an intersection
-    return true;
 }
 
 glm::vec3 SegmentWidget::getCameraFront() const {
     glm::vec3 front;
-    front.x = cos(glm::radians(m_cameraYaw)) * cos(glm::radians(m_cameraPitch));
-    front.y = sin(glm::radians(m_cameraPitch));
-    front.z = sin(glm::radians(m_cameraYaw)) * cos(glm::radians(m_cameraPitch));
+    front.x = cos(glm::radians(m_camera.yaw)) * cos(glm::radians(m_camera.pitch));
+    front.y = sin(glm::radians(m_camera.pitch));
+    front.z = sin(glm::radians(m_camera.yaw)) * cos(glm::radians(m_camera.pitch));
     return glm::normalize(front);
 }
 
 QVector3D SegmentWidget::getCameraForward() {
     QVector3D forward;
-    forward.setX(cos(qDegreesToRadians(m_cameraYaw)) * cos(qDegreesToRadians(m_cameraPitch)));
-    forward.setY(sin(qDegreesToRadians(m_cameraPitch)));
-    forward.setZ(sin(qDegreesToRadians(m_cameraYaw)) * cos(qDegreesToRadians(m_cameraPitch)));
+    forward.setX(cos(qDegreesToRadians(m_camera.yaw)) * cos(qDegreesToRadians(m_camera.pitch)));
+    forward.setY(sin(qDegreesToRadians(m_camera.pitch)));
+    forward.setZ(sin(qDegreesToRadians(m_camera.yaw)) * cos(qDegreesToRadians(m_camera.pitch)));
     return forward.normalized();
 }
 
 int SegmentWidget::getSelectedIndex(Rect3D rect) {
-    for (size_t i = 0; i < m_rects->size(); i++) {
-        if (m_rects->at(i) == rect) {
+    for (size_t i = 0; i < m_store->size(); i++) {
+        if (m_store->box(i) == rect) {
             return i;
         }
     } return 0;
@@ -562,7 +347,7 @@ glm::vec3 SegmentWidget::getRayFromMouse(int mouseX, int mouseY) {
     viewMatrix = getViewMatrix();
 
     // Transform to eye space
-    glm::vec4 rayEye = glm::inverse(projectionMatrix) * rayClip;
+    glm::vec4 rayEye = glm::inverse(m_renderer.projectionMatrix()) * rayClip;
     rayEye = glm::vec4(rayEye.x, rayEye.y, -1.0f, 0.0f);
 
     // Transform to world space
@@ -688,28 +473,28 @@ void SegmentWidget::selectCube(const QPoint& mousePos) {
     float y = 1.0f - (2.0f * mousePos.y()) / height();
     glm::vec4 rayClip(x, y, -1.0f, 1.0f);
 
-    glm::vec4 rayEye = glm::inverse(projectionMatrix) * rayClip;
+    glm::vec4 rayEye = glm::inverse(m_renderer.projectionMatrix()) * rayClip;
     rayEye = glm::vec4(rayEye.x, rayEye.y, -1.0f, 0.0f);
 
-    viewMatrix = toMat4(getMVP(m_model));
+    viewMatrix = toMat4(getMVP(m_renderer.model()));
 
     glm::vec4 rayWorld = glm::inverse(viewMatrix) * rayEye;
     glm::vec3 rayDir = glm::normalize(glm::vec3(rayWorld));
 
     glm::vec3 cameraPos = glm::vec3(glm::inverse(viewMatrix)[3]);
 
-    cameraPos = toVec3(m_cameraPosition);
+    cameraPos = toVec3(m_camera.position);
 
     if (m_useShader) m_debugRayStart = cameraPos * 2.0f;
     else m_debugRayStart = cameraPos;
 
     auto vm = fromMat4(viewMatrix);
-    auto pm = fromMat4(projectionMatrix);
+    auto pm = fromMat4(m_renderer.projectionMatrix());
 
     QVector3D rayDire = unprojectRay(vm, pm, width(), height(), mousePos);
 
     glm::vec4 viewport = {0, 0, width(), height()};
-    glm::vec3 pos = glm::unProject({mousePos.x(), height()-mousePos.y(), 1}, toMat4(getMVP(m_model)), projectionMatrix, viewport);
+    glm::vec3 pos = glm::unProject({mousePos.x(), height()-mousePos.y(), 1}, toMat4(getMVP(m_renderer.model())), m_renderer.projectionMatrix(), viewport);
 
 
     m_debugRayEnd = cameraPos + pos * 100.0f;
@@ -726,8 +511,8 @@ void SegmentWidget::selectCube(const QPoint& mousePos) {
 
     //glm::vec4 viewport(0, 0, width(), height());
 
-    glm::vec3 rayStartNDC = glm::unProject(glm::vec3(screenPos, 0.1f), viewMatrix, projectionMatrix, viewport); // Near plane
-    glm::vec3 rayEndNDC   = glm::unProject(glm::vec3(screenPos, 1000.0f), viewMatrix, projectionMatrix, viewport); // Far plane
+    glm::vec3 rayStartNDC = glm::unProject(glm::vec3(screenPos, 0.1f), viewMatrix, m_renderer.projectionMatrix(), viewport); // Near plane
+    glm::vec3 rayEndNDC   = glm::unProject(glm::vec3(screenPos, 1000.0f), viewMatrix, m_renderer.projectionMatrix(), viewport); // Far plane
 
     // Create ray
     glm::vec3 rayOrigin = rayStartNDC;
@@ -749,7 +534,7 @@ void SegmentWidget::selectCube(const QPoint& mousePos) {
     float ndcY = 1.0f - (2.0f * y) / height(); // Normalize Y to [-1, 1] and flip Y
 
     // Use FOV to adjust the ray's scale. (For example, let's assume FOV is 45 degrees)
-    float fov = m_cameraFov;  // Field of view in degrees (adjust as necessary)
+    float fov = m_camera.fov;  // Field of view in degrees (adjust as necessary)
     float aspectRatio = (float)width() / height();
     float fovRad = glm::radians(fov);  // Convert to radians
 
@@ -766,8 +551,8 @@ void SegmentWidget::selectCube(const QPoint& mousePos) {
     QMatrix4x4 rotationMatrix;
 
     // Apply rotations only around the Z and X axes for yaw and pitch respectively
-    rotationMatrix.rotate(m_cameraPitch, QVector3D(1.0f, 0.0f, 0.0f));  // Pitch rotation (around X-axis)
-    rotationMatrix.rotate(m_cameraYaw - 90.0f, QVector3D(0.0f, 1.0f, 0.0f));    // Yaw rotation (around Y-axis)
+    rotationMatrix.rotate(m_camera.pitch, QVector3D(1.0f, 0.0f, 0.0f));  // Pitch rotation (around X-axis)
+    rotationMatrix.rotate(m_camera.yaw - 90.0f, QVector3D(0.0f, 1.0f, 0.0f));    // Yaw rotation (around Y-axis)
 
     // Apply the rotation to the ray direction
     QVector3D rayDirectionInWorldSpace = rotationMatrix.map(rayDirectionInScreenSpace);
@@ -776,7 +561,7 @@ void SegmentWidget::selectCube(const QPoint& mousePos) {
     rayDirectionInWorldSpace = rayDirectionInWorldSpace.normalized();
 
     // Now that the ray is adjusted, set the ray origin (the camera position)
-    glm::vec3 rayOrigin = toVec3(m_cameraPosition);
+    glm::vec3 rayOrigin = toVec3(m_camera.position);
 
     // Now the ray direction in world space is ready to be used
     glm::vec3 rayDirection = toVec3(rayDirectionInWorldSpace);  // Convert to your custom type if necessary
@@ -790,25 +575,23 @@ void SegmentWidget::selectCube(const QPoint& mousePos) {
 
     m_drawDebugRay = true;
 
-    Rect3D* selectedCube = nullptr;
-    bool found = false;
+    std::optional<Rect3D> selectedCube;
 
-    m_selectedRects->clear();
+    m_selection->clear();
 
-    // 4. Test intersections
-    for(Rect3D& cube : *m_rects) {
-        if (intersects(m_debugRayDir, m_debugRayStart, cube)) {
-            m_selectedRects->push_back(&cube);
-            selectedCube = &cube;
-            found = true;
-            break;
-        }
+    // 4. Nearest box along the ray
+    QVector3D pickOrigin(m_debugRayStart.x, m_debugRayStart.y, m_debugRayStart.z);
+    QVector3D pickDirection(m_debugRayDir.x, m_debugRayDir.y, m_debugRayDir.z);
+
+    if (auto hit = BoxRaycast::nearest(m_store->boxes(), pickOrigin, pickDirection)) {
+        m_selection->add(m_store->handleAt(hit->index));
+        selectedCube = m_store->box(hit->index);
     }
 
     auto window = qobject_cast<MainWindow*>(m_parent);
-    window->update2D();
+    window->updateAllViews();
 
-    if (found && selectedCube) {
+    if (selectedCube) {
         qDebug() << "Selected cube at: ("
                  << selectedCube->x() << ", "
                  << selectedCube->y() << ", "
@@ -821,6 +604,9 @@ void SegmentWidget::selectCube(const QPoint& mousePos) {
 void SegmentWidget::keyPressEvent(QKeyEvent *event) {
     m_pressedKeys.insert(event->key());
 
+    // Starts the frame loop for movement keys, and shows any toggle below
+    requestRepaint();
+
     if (event->key() == Qt::Key_F1) {
         m_drawFaces = !m_drawFaces;
         auto window = qobject_cast<MainWindow*>(m_parent);
@@ -841,45 +627,43 @@ void SegmentWidget::keyPressEvent(QKeyEvent *event) {
         auto window = qobject_cast<MainWindow*>(m_parent);
         window->toggleGameView->setChecked(m_gameView);
     }
+    if (event->key() == Qt::Key_F9) {
+        setShowProfiler(!m_renderer.profiler().isEnabled());
+        auto window = qobject_cast<MainWindow*>(m_parent);
+        window->toggleProfiler->setChecked(m_renderer.profiler().isEnabled());
+    }
     if (event->key() == Qt::Key_F7) {
-        if (!m_rects->empty()) {
-
-            const Rect3D* minZCube = nullptr;
-            const Rect3D* maxZCube = nullptr;
-
-            for (const auto& cube : *m_rects) {
-                if (!minZCube || cube.position().z() < minZCube->position().z()) {
-                    minZCube = &cube;
-                }
-                if (!maxZCube || cube.position().z() > maxZCube->position().z()) {
-                    maxZCube = &cube;
-                }
-            }
-
-            if (minZCube && maxZCube) {
-                float zDistance = std::abs(maxZCube->position().z() - minZCube->position().z());
-
-                m_cameraSpeed = zDistance / (30.0f * 240.0f);
-                qDebug() << "Distance along Z axis between furthest and closest cubes:" << zDistance;
-            }
-
+        if (!m_store->isEmpty()) {
+            m_cameraSpeed = gameViewRunSpeed(m_store->boxes());
+            qDebug() << "Game view speed set to" << m_cameraSpeed;
         }
-
+    }
+    if (event->key() == Qt::Key_F10) {
+        if (m_recordingPath) {
+            m_recordedPath.save("flythrough.campath");
+            qDebug() << "Saved" << m_recordedPath.size() << "camera frames to flythrough.campath";
+        } else {
+            m_recordedPath.clear();
+            qDebug() << "Recording camera path";
+        }
+        m_recordingPath = !m_recordingPath;
     }
     if (event->key() == Qt::Key_F8) {
         if (m_gameView) {
-            m_gameViewPosition = 0.0f;
+            m_camera.gameViewPosition = 0.0f;
         } else {
-            m_cameraPosition = QVector3D(0.0f, 0.0f, 0.0f);
-            m_cameraYaw = 0.0f;
-            m_cameraPitch = 0.0f;
+            m_camera.position = QVector3D(0.0f, 0.0f, 0.0f);
+            m_camera.yaw = 0.0f;
+            m_camera.pitch = 0.0f;
         }
+        snapCamera();
         
     }
 }
 
 void SegmentWidget::keyReleaseEvent(QKeyEvent *event) {
     m_pressedKeys.remove(event->key());
+    requestRepaint();
 }
 
 void SegmentWidget::mousePressEvent(QMouseEvent *event) {
@@ -933,308 +717,19 @@ void SegmentWidget::mouseMoveEvent(QMouseEvent *event) {
         m_lastMousePos = event->pos();
 
         // Update yaw and pitch based on mouse movement
-        m_cameraYaw -= delta.x() * m_mouseSensitivity / 10;  // Horizontal movement (yaw)
-        m_cameraPitch -= delta.y() * m_mouseSensitivity / 10;  // Vertical movement (pitch)
+        m_camera.yaw -= delta.x() * m_mouseSensitivity / 10;  // Horizontal movement (yaw)
+        m_camera.pitch -= delta.y() * m_mouseSensitivity / 10;  // Vertical movement (pitch)
 
         // Clamp pitch to prevent flipping
-        if (m_cameraPitch > 89.0f) m_cameraPitch = 89.0f;
-        if (m_cameraPitch < -89.0f) m_cameraPitch = -89.0f;
+        if (m_camera.pitch > 89.0f) m_camera.pitch = 89.0f;
+        if (m_camera.pitch < -89.0f) m_camera.pitch = -89.0f;
 
         // Normalize yaw to keep it in the 0-360 range
-        m_cameraYaw = std::fmod(m_cameraYaw + 360.0f, 360.0f);
+        m_camera.yaw = std::fmod(m_camera.yaw + 360.0f, 360.0f);
 
         // Reset cursor to the center of the widget
         QCursor::setPos(mapToGlobal(center));
-    }
-}
-
-QOpenGLShaderProgram *SegmentWidget::createShaderProgram(const QString& name) {
-    QOpenGLShaderProgram *program = new QOpenGLShaderProgram();
-
-    QString vertPath = QString(":/res/shaders/%1.vert").arg(name);
-    QString fragPath = QString(":/res/shaders/%1.frag").arg(name);
-
-    if (!program->addShaderFromSourceFile(QOpenGLShader::Vertex, vertPath))
-        qWarning() << "Vertex shader failed:" << program->log();
-
-    if (!program->addShaderFromSourceFile(QOpenGLShader::Fragment, fragPath))
-        qWarning() << "Fragment shader failed:" << program->log();
-
-    if (!program->link())
-        qWarning() << "Shader linking failed:" << program->log();
-
-    return program;
-}
-
-glm::vec3 operator+(const QVector3D& left, const glm::vec3& right) {
-    glm::vec3 newVec = toVec3(left);
-    return newVec + right;
-}
-
-void SegmentWidget::drawCubeNew(const Rect3D& rect, bool selected) {
-    glm::vec3 p1 = rect.position() + glm::vec3(-rect.size().x(), -rect.size().y(), -rect.size().z());
-    glm::vec3 p2 = rect.position() + glm::vec3( rect.size().x(), -rect.size().y(), -rect.size().z());
-    glm::vec3 p3 = rect.position() + glm::vec3( rect.size().x(),  rect.size().y(), -rect.size().z());
-    glm::vec3 p4 = rect.position() + glm::vec3(-rect.size().x(),  rect.size().y(), -rect.size().z());
-    glm::vec3 p5 = rect.position() + glm::vec3(-rect.size().x(), -rect.size().y(),  rect.size().z());
-    glm::vec3 p6 = rect.position() + glm::vec3( rect.size().x(), -rect.size().y(),  rect.size().z());
-    glm::vec3 p7 = rect.position() + glm::vec3( rect.size().x(),  rect.size().y(),  rect.size().z());
-    glm::vec3 p8 = rect.position() + glm::vec3(-rect.size().x(),  rect.size().y(),  rect.size().z());
-
-    // Each face has 6 vertices (2 triangles) with position, color, and texture coordinates
-    // Winding order is COUNTER-CLOCKWISE when viewed from outside
-    GLfloat vertices[] = {
-
-        // Front face (p1, p2, p3, p1, p3, p4) - Z-
-        p1.x, p1.y, p1.z,  0.0f, 0.0f,
-        p2.x, p2.y, p2.z,  1.0f, 0.0f,
-        p3.x, p3.y, p3.z,  1.0f, 1.0f,
-        p1.x, p1.y, p1.z,  0.0f, 0.0f,
-        p3.x, p3.y, p3.z,  1.0f, 1.0f,
-        p4.x, p4.y, p4.z,  0.0f, 1.0f,
-
-        // Back face (p6, p5, p8, p6, p8, p7) - Z+
-        p6.x, p6.y, p6.z,  0.0f, 0.0f,
-        p5.x, p5.y, p5.z,  1.0f, 0.0f,
-        p8.x, p8.y, p8.z,  1.0f, 1.0f,
-        p6.x, p6.y, p6.z,  0.0f, 0.0f,
-        p8.x, p8.y, p8.z,  1.0f, 1.0f,
-        p7.x, p7.y, p7.z,  0.0f, 1.0f,
-
-        // Left face (p5, p1, p4, p5, p4, p8) - X-
-        p5.x, p5.y, p5.z,  0.0f, 0.0f,
-        p1.x, p1.y, p1.z,  1.0f, 0.0f,
-        p4.x, p4.y, p4.z,  1.0f, 1.0f,
-        p5.x, p5.y, p5.z,  0.0f, 0.0f,
-        p4.x, p4.y, p4.z,  1.0f, 1.0f,
-        p8.x, p8.y, p8.z,  0.0f, 1.0f,
-
-        // Right face (p2, p6, p7, p2, p7, p3) - X+
-        p2.x, p2.y, p2.z,  0.0f, 0.0f,
-        p6.x, p6.y, p6.z,  1.0f, 0.0f,
-        p7.x, p7.y, p7.z,  1.0f, 1.0f,
-        p2.x, p2.y, p2.z,  0.0f, 0.0f,
-        p7.x, p7.y, p7.z,  1.0f, 1.0f,
-        p3.x, p3.y, p3.z,  0.0f, 1.0f,
-
-        // Top face (p4, p3, p7, p4, p7, p8) - Y+
-        p4.x, p4.y, p4.z,  0.0f, 0.0f,
-        p3.x, p3.y, p3.z,  1.0f, 0.0f,
-        p7.x, p7.y, p7.z,  1.0f, 1.0f,
-        p4.x, p4.y, p4.z,  0.0f, 0.0f,
-        p7.x, p7.y, p7.z,  1.0f, 1.0f,
-        p8.x, p8.y, p8.z,  0.0f, 1.0f,
-
-        // Bottom face (p1, p5, p6, p1, p6, p2) - Y-
-        p1.x, p1.y, p1.z,  0.0f, 0.0f,
-        p5.x, p5.y, p5.z,  1.0f, 0.0f,
-        p6.x, p6.y, p6.z,  1.0f, 1.0f,
-        p1.x, p1.y, p1.z,  0.0f, 0.0f,
-        p6.x, p6.y, p6.z,  1.0f, 1.0f,
-        p2.x, p2.y, p2.z,  0.0f, 1.0f
-
-    };
-
-    m_model = QMatrix4x4();
-
-    if (m_gameView) m_model.translate(0, -1, m_gameViewPosition);
-    else m_model.translate(-m_cameraPosition.x(), -m_cameraPosition.y(), -m_cameraPosition.z());
-        
-    QMatrix4x4 mvp = getMVP(m_model);
-
-    m_basicProgram->setUniformValue("uMvpMatrix", mvp);
-    m_basicProgram->setUniformValue("uLowerFog", QVector4D(lowerFogColour[0], lowerFogColour[1], lowerFogColour[2], lowerFogColour[3]));
-    m_basicProgram->setUniformValue("uUpperFog", QVector4D(upperFogColour[0], upperFogColour[1], upperFogColour[2], upperFogColour[3]));
-    m_basicProgram->setUniformValue("uIsSelected", selected);
-    m_basicProgram->setUniformValue("uTexture0", 0);
-
-    m_basicProgram->setAttributeValue("aColor", rect.getColourVector());
-
-    GLuint color = m_basicProgram->attributeLocation("aColor");
-    GLuint position = m_basicProgram->attributeLocation("aPosition");
-    GLuint texCoord = m_basicProgram->attributeLocation("aTexCoord");
-
-    glActiveTexture(GL_TEXTURE0);
-    tileTex->bind();
-
-    GLuint VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    //m_basicProgram->enableAttributeArray(color);
-    //m_basicProgram->setAttributeBuffer(color, GL_FLOAT, 0, 4, 5 * sizeof(GLfloat)); // color (now 4 floats)
-    
-    m_basicProgram->enableAttributeArray(position);
-    m_basicProgram->setAttributeBuffer(position, GL_FLOAT, 0, 3, 5 * sizeof(GLfloat)); // position
-    
-    m_basicProgram->enableAttributeArray(texCoord);
-    m_basicProgram->setAttributeBuffer(texCoord, GL_FLOAT, 0, 2, 5 * sizeof(GLfloat)); // texcoord
 
-    // Position attribute
-    //glEnableVertexAttribArray(position);
-    //glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)0);           // position
-    
-
-    // Color attribute
-    //glVertexAttribPointer(color, 4, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat))); // color (now 4 floats)
-    //glEnableVertexAttribArray(1);
-
-    //glEnableVertexAttribArray(color);
-    //m_basicProgram->setAttributeValue("aColor", rect.getColourVector());
-
-    // Texture coordinate attribute
-    //glEnableVertexAttribArray(texCoord);
-    //glVertexAttribPointer(texCoord, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)(7 * sizeof(GLfloat))); // texcoord
-
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_FRONT); 
-    glFrontFace(GL_CCW);
-
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36); // 6 faces × 6 vertices = 36 vertices
-
-    // Cleanup
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    
-}
-
-void SegmentWidget::drawCube(const Rect3D& cubeRect, bool selected) {
-    float x0 = cubeRect.x() - cubeRect.width();
-    float x1 = cubeRect.x() + cubeRect.width();
-    float y0 = cubeRect.y() - cubeRect.height();
-    float y1 = cubeRect.y() + cubeRect.height();
-    float z0 = cubeRect.z() - cubeRect.depth();
-    float z1 = cubeRect.z() + cubeRect.depth();
-
-    glEnable(GL_POLYGON_OFFSET_FILL);
-    glPolygonOffset(1.0, 1.0);
-
-    glBegin(GL_QUADS);
-
-    if (!selected) {
-
-        if (m_drawColour) {
-
-            auto colour = cubeRect.getColour();
-
-            glColor3f(colour[0], colour[1], colour[2]);
-
-            glVertex3f(x0, y0, z1); glVertex3f(x1, y0, z1); glVertex3f(x1, y1, z1); glVertex3f(x0, y1, z1);
-            glVertex3f(x1, y0, z0); glVertex3f(x0, y0, z0); glVertex3f(x0, y1, z0); glVertex3f(x1, y1, z0);
-            glVertex3f(x0, y0, z0); glVertex3f(x0, y0, z1); glVertex3f(x0, y1, z1); glVertex3f(x0, y1, z0);
-            glVertex3f(x1, y0, z1); glVertex3f(x1, y0, z0); glVertex3f(x1, y1, z0); glVertex3f(x1, y1, z1);
-            glVertex3f(x0, y1, z1); glVertex3f(x1, y1, z1); glVertex3f(x1, y1, z0); glVertex3f(x0, y1, z0);
-            glVertex3f(x0, y0, z0); glVertex3f(x1, y0, z0); glVertex3f(x1, y0, z1); glVertex3f(x0, y0, z1);
-        } else {
-            glColor3f(1, 0, 0); glVertex3f(x0, y0, z1); glVertex3f(x1, y0, z1); glVertex3f(x1, y1, z1); glVertex3f(x0, y1, z1);
-            glColor3f(0, 1, 0); glVertex3f(x1, y0, z0); glVertex3f(x0, y0, z0); glVertex3f(x0, y1, z0); glVertex3f(x1, y1, z0);
-            glColor3f(0, 0, 1); glVertex3f(x0, y0, z0); glVertex3f(x0, y0, z1); glVertex3f(x0, y1, z1); glVertex3f(x0, y1, z0);
-            glColor3f(1, 1, 0); glVertex3f(x1, y0, z1); glVertex3f(x1, y0, z0); glVertex3f(x1, y1, z0); glVertex3f(x1, y1, z1);
-            glColor3f(1, 0, 1); glVertex3f(x0, y1, z1); glVertex3f(x1, y1, z1); glVertex3f(x1, y1, z0); glVertex3f(x0, y1, z0);
-            glColor3f(0, 1, 1); glVertex3f(x0, y0, z0); glVertex3f(x1, y0, z0); glVertex3f(x1, y0, z1); glVertex3f(x0, y0, z1);
-        }
-
-    } else {
-        glColor3f(1.0, 0.0, 0.0);
-
-        glVertex3f(x0, y0, z1); glVertex3f(x1, y0, z1); glVertex3f(x1, y1, z1); glVertex3f(x0, y1, z1);
-        glVertex3f(x1, y0, z0); glVertex3f(x0, y0, z0); glVertex3f(x0, y1, z0); glVertex3f(x1, y1, z0);
-        glVertex3f(x0, y0, z0); glVertex3f(x0, y0, z1); glVertex3f(x0, y1, z1); glVertex3f(x0, y1, z0);
-        glVertex3f(x1, y0, z1); glVertex3f(x1, y0, z0); glVertex3f(x1, y1, z0); glVertex3f(x1, y1, z1);
-        glVertex3f(x0, y1, z1); glVertex3f(x1, y1, z1); glVertex3f(x1, y1, z0); glVertex3f(x0, y1, z0);
-        glVertex3f(x0, y0, z0); glVertex3f(x1, y0, z0); glVertex3f(x1, y0, z1); glVertex3f(x0, y0, z1);
+        requestRepaint();
     }
-
-    glEnd();
-    glDisable(GL_POLYGON_OFFSET_FILL);
-
-    // Draw grid lines (if m_drawColour is true)
-    if (m_drawColour) {
-
-        auto colour = cubeRect.getColour();
-        glColor3f(
-            colour[0] * 0.7f,
-            colour[1] * 0.7f,
-            colour[2] * 0.7f
-            );
-
-        glLineWidth(2.0f);  // <-- Make the grid lines thicker (default is 1.0)
-
-        glBegin(GL_LINES);
-
-        // Grid on Front and Back faces (XY plane at Z = z1 and Z = z0)
-        for (float x = std::ceil(x0); x <= x1; x += 1.0f) {
-            glVertex3f(x, y0, z1); glVertex3f(x, y1, z1);  // Front
-            glVertex3f(x, y0, z0); glVertex3f(x, y1, z0);  // Back
-        }
-        for (float y = std::ceil(y0); y <= y1; y += 1.0f) {
-            glVertex3f(x0, y, z1); glVertex3f(x1, y, z1);  // Front
-            glVertex3f(x0, y, z0); glVertex3f(x1, y, z0);  // Back
-        }
-
-        // Grid on Left and Right faces (YZ plane at X = x0 and X = x1)
-        for (float y = std::ceil(y0); y <= y1; y += 1.0f) {
-            glVertex3f(x0, y, z0); glVertex3f(x0, y, z1);  // Left
-            glVertex3f(x1, y, z0); glVertex3f(x1, y, z1);  // Right
-        }
-        for (float z = std::ceil(z0); z <= z1; z += 1.0f) {
-            glVertex3f(x0, y0, z); glVertex3f(x0, y1, z);  // Left
-            glVertex3f(x1, y0, z); glVertex3f(x1, y1, z);  // Right
-        }
-
-        // Grid on Top and Bottom faces (XZ plane at Y = y1 and Y = y0)
-        for (float x = std::ceil(x0); x <= x1; x += 1.0f) {
-            glVertex3f(x, y1, z0); glVertex3f(x, y1, z1);  // Top
-            glVertex3f(x, y0, z0); glVertex3f(x, y0, z1);  // Bottom
-        }
-        for (float z = std::ceil(z0); z <= z1; z += 1.0f) {
-            glVertex3f(x0, y1, z); glVertex3f(x1, y1, z);  // Top
-            glVertex3f(x0, y0, z); glVertex3f(x1, y0, z);  // Bottom
-        }
-
-        glEnd();
-    }
-}
-
-
-void SegmentWidget::drawCubeOutline(const Rect3D& cubeRect) {
-    float x0 = cubeRect.x() - cubeRect.width();
-    float x1 = cubeRect.x() + cubeRect.width();
-    float y0 = cubeRect.y() - cubeRect.height();
-    float y1 = cubeRect.y() + cubeRect.height();
-    float z0 = cubeRect.z() - cubeRect.depth();
-    float z1 = cubeRect.z() + cubeRect.depth();
-
-    glLineWidth(1.0f);
-
-    // Set line color for the outline
-    glBegin(GL_LINES);
-
-    glColor3f(1.0f, 1.0, 0.0f); // Yellow for the outline
-
-    // Front face edges
-    glVertex3f(x0, y0, z1); glVertex3f(x1, y0, z1);
-    glVertex3f(x1, y0, z1); glVertex3f(x1, y1, z1);
-    glVertex3f(x1, y1, z1); glVertex3f(x0, y1, z1);
-    glVertex3f(x0, y1, z1); glVertex3f(x0, y0, z1);
-
-    // Back face edges
-    glVertex3f(x0, y0, z0); glVertex3f(x1, y0, z0);
-    glVertex3f(x1, y0, z0); glVertex3f(x1, y1, z0);
-    glVertex3f(x1, y1, z0); glVertex3f(x0, y1, z0);
-    glVertex3f(x0, y1, z0); glVertex3f(x0, y0, z0);
-
-    // Connecting edges between front and back faces
-    glVertex3f(x0, y0, z0); glVertex3f(x0, y0, z1);
-    glVertex3f(x1, y0, z0); glVertex3f(x1, y0, z1);
-    glVertex3f(x0, y1, z0); glVertex3f(x0, y1, z1);
-    glVertex3f(x1, y1, z0); glVertex3f(x1, y1, z1);
-
-    glEnd();
 }
@@ -6,6 +6,7 @@
 #include <QOpenGLFunctions_3_3_Core>
 #include <QWidget>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <Qt3DExtras/Qt3DWindow>
 #include <Qt3DExtras/QOrbitCameraController>
 #include <Qt3DCore/QEntity>
@@ -13,6 +14,10 @@
 #include <QVBoxLayout>
 #include <QKeyEvent>
 #include "Rect3D.h"
+#include "SegmentRenderer.h"
+#include "Selection.h"
+#include "CameraPath.h"
+#include "RepaintScheduler.h"
 #include <QMainWindow>
 #include <QKeyEvent>
 #include <QMouseEvent>
@@ -59,16 +64,22 @@ class SegmentWidget : public QOpenGLWidget, public QOpenGLFunctions_3_3_Core {
     Q_OBJECT
 
 public:
-    explicit SegmentWidget(QWidget *parent = nullptr, std::vector<Rect3D> *rects = nullptr, std::vector<Rect3D*> *selectedRects = nullptr);
+    explicit SegmentWidget(QWidget *parent = nullptr, SceneStore *store = nullptr, Selection *selection = nullptr);
+    ~SegmentWidget();
 
     std::vector<Rect3D> getRects();
 
     void setRects(const std::vector<Rect3D>& newRects);
-    void loadTileTexture();
 
     void setFov(int value);
     void setSens(float value);
     void setRootDir(QString rootDir);
+    void setShowProfiler(bool show);
+    void setSceneBuffers(SceneBuffers *buffers) { m_renderer.setSceneBuffers(buffers); }
+    void setRepaintScheduler(RepaintScheduler *scheduler) { m_scheduler = scheduler; }
+
+    // The view only repaints on request, or every frame while the camera is moving
+    void requestRepaint();
 
     bool m_drawWireframe;
     bool m_drawFaces;
@@ -86,9 +97,11 @@ protected:
 
     void paintGL() override;
 
+    // One fixed simulation tick of keyboard movement
     void handleInput();
 
-    bool intersects(const glm::vec3& ray, const glm::vec3& rayOrigin, const Rect3D& cube);
+    // Movement keys held, or anything else that needs another frame straight away
+    bool isAnimating() const;
 
     glm::vec3 getCameraFront() const;
 
@@ -111,23 +124,27 @@ protected:
     void mouseMoveEvent(QMouseEvent *event) override;
 
 private:
-    QVector3D m_cameraPosition;  // Camera position in 3D space
-    float m_cameraYaw;           // Camera rotation (yaw)
-    float m_cameraPitch;         // Camera rotation (pitch)
-    float m_cameraSpeed;         // Camera movement speed
-    float m_cameraFov;
-    float m_gameViewPosition;
+    RenderCamera m_camera;       // Position, rotation, fov and game view distance
+    float m_cameraSpeed;         // Camera movement per tick
+
+    // Movement runs at a fixed 240 Hz, the rate the speeds (and F7's 30 * 240) were tuned for,
+    // and paintGL draws the camera interpolated between the previous and current tick
+    static constexpr double kTickInterval = 1.0 / 240.0;
+    static constexpr double kMaxTickBacklog = 0.25;
+    RenderCamera m_previousCamera;
+    QElapsedTimer m_tickClock;
+    double m_tickAccumulator = 0.0;
+    float m_tickAlpha = 1.0f;
     float m_mouseSensitivity;    // Mouse sensitivity for rotation
     bool m_isDragging;           // Whether the right mouse button is being held down
     QPoint m_lastMousePos;       // Last position of the mouse
     bool m_glToggle;
     QWidget *m_parent;
-    glm::mat4 projectionMatrix;
     glm::mat4 viewMatrix;
 
-    std::vector<Rect3D*> *m_selectedRects;
+    Selection *m_selection;
 
-    std::vector<Rect3D> *m_rects;
+    SceneStore *m_store;
     QSet<int> m_pressedKeys;
 
     QString m_rootDir;
@@ -138,7 +155,19 @@ private:
     glm::vec3 m_debugRayStart;
     glm::vec3 m_debugRayDir;
     glm::vec3 m_debugRayEnd;
-    QMatrix4x4 m_model;
+
+    SegmentRenderer m_renderer;
+    RepaintScheduler *m_scheduler = nullptr;
+
+    // F10 records the camera every tick so the benchmark can replay it
+    bool m_recordingPath = false;
+    CameraPath m_recordedPath;
+
+    RenderCamera camera() const;
+    void simulate();
+    // Call after teleporting the camera so it doesn't slide there over one tick
+    void snapCamera();
+    RenderOptions renderOptions() const;
 
     glm::mat4 computeCubeTransform(const Rect3D& cube);
 
@@ -154,34 +183,8 @@ private:
         glm::vec3& out_origin,
         glm::vec3& out_direction);
 
-    QOpenGLTexture *tileTex;
-
-    GLuint m_tileTexture;
-    QOpenGLTexture *loadTexture(QString filename);
-    const unsigned char *tileData;
-
-    // Fog shader stuff
-    QOpenGLShaderProgram *m_roomProgram;
-    QOpenGLShaderProgram *m_clearProgram;
-    QOpenGLShaderProgram *m_basicProgram;
-
-    GLuint loadShaderFromFile(const QString& path, GLenum type);
-    QOpenGLShaderProgram *createShaderProgram(const QString& path);
-
     QMatrix4x4 getMVP(const QMatrix4x4& model);
 
-    void updateProjectionMatrix();
-
-    void drawDebugRay();
-
-    void drawCubeSpecial(const Rect3D& cubeRect);
-
-    void drawCubeNew(const Rect3D& rect, bool selected);
-
-    void drawCube(const Rect3D& cubeRect, bool selected = false);
-
-    void drawCubeOutline(const Rect3D& cubeRect);
-
 };
 
 #endif // SEGMENTWIDGET_H
@@ -0,0 +1,81 @@
+#include "Selection.h"
+#include <algorithm>
+
+void Selection::add(BoxHandle handle) {
+    if (!m_store->contains(handle) || m_store->isSelected(handle)) return;
+
+    m_store->setSelected(handle, true);
+    m_items.push_back(handle);
+    m_revision++;
+}
+
+void Selection::add(const std::vector<BoxHandle>& handles) {
+    std::vector<BoxHandle> added = unselectedOf(handles);
+    if (added.empty()) return;
+
+    // One store call, so a marquee over a loaded segment is a notification or two, not one per box
+    m_store->setSelected(added, true);
+    m_items.insert(m_items.end(), added.begin(), added.end());
+    m_revision++;
+}
+
+void Selection::remove(const std::vector<BoxHandle>& handles) {
+    if (m_store->setSelected(handles, false) == 0) return;
+
+    dropUnselected();
+    m_revision++;
+}
+
+void Selection::toggle(const std::vector<BoxHandle>& handles) {
+    std::vector<BoxHandle> added = unselectedOf(handles);
+    size_t removed = m_store->setSelected(handles, false);
+
+    m_store->setSelected(added, true);
+    m_items.insert(m_items.end(), added.begin(), added.end());
+
+    if (removed > 0) dropUnselected();
+    if (removed > 0 || !added.empty()) m_revision++;
+}
+
+void Selection::replace(const std::vector<BoxHandle>& handles) {
+    size_t removed = m_store->setSelected(m_items, false);
+    m_items.clear();
+
+    quint64 revision = m_revision;
+    add(handles);
+    if (removed > 0 && m_revision == revision) m_revision++;
+}
+
+void Selection::clear() {
+    if (m_items.empty()) return;
+
+    m_store->setSelected(m_items, false);
+    m_items.clear();
+    m_revision++;
+}
+
+void Selection::discard() {
+    m_items.clear();
+    m_revision++;
+}
+
+void Selection::dropUnselected() {
+    // One pass for a whole batch, instead of a find per removed box. Stale handles read as unselected.
+    m_items.erase(std::remove_if(m_items.begin(), m_items.end(), [this](BoxHandle handle) {
+        return !m_store->isSelected(handle);
+    }), m_items.end());
+}
+
+std::vector<BoxHandle> Selection::unselectedOf(const std::vector<BoxHandle>& handles) const {
+    std::vector<BoxHandle> unselected;
+    std::vector<bool> listed(m_store->size(), false);
+
+    for (BoxHandle handle : handles) {
+        int index = m_store->indexOf(handle);
+        if (index < 0 || listed[index] || m_store->boxes().isSelected(index)) continue;
+
+        listed[index] = true;
+        unselected.push_back(handle);
+    }
+    return unselected;
+}
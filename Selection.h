@@ -0,0 +1,49 @@
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include <QtGlobal>
+#include <vector>
+#include "SceneStore.h"
+
+// The selected boxes. Membership lives in the store's selected plane, so contains() is O(1) in
+// draw loops. The list keeps selection order for operations like move and delete, as handles,
+// so boxes removed from the store just drop out.
+class Selection {
+public:
+    explicit Selection(SceneStore *store) : m_store(store) {}
+
+    bool contains(BoxHandle handle) const { return m_store->isSelected(handle); }
+
+    void add(BoxHandle handle);
+    void add(const std::vector<BoxHandle>& handles);
+    void remove(const std::vector<BoxHandle>& handles);
+    void toggle(const std::vector<BoxHandle>& handles);
+
+    // Same as clear() then add(), with a single revision bump
+    void replace(const std::vector<BoxHandle>& handles);
+
+    void clear();
+
+    // The selected boxes were just removed from the store, so there are no flags left to reset
+    void discard();
+
+    // May hold handles the store has since dropped, resolve them with SceneStore::indexOf() or find()
+    const std::vector<BoxHandle>& items() const { return m_items; }
+    bool isEmpty() const { return m_items.empty(); }
+    size_t size() const { return m_items.size(); }
+
+    // Bumped on every change and only then, so views and buffers can tell cheaply whether to refresh
+    quint64 revision() const { return m_revision; }
+
+private:
+    SceneStore *m_store;
+    std::vector<BoxHandle> m_items;
+    quint64 m_revision = 0;
+
+    void dropUnselected();
+
+    // The live, unselected boxes of handles, each once and in the order given
+    std::vector<BoxHandle> unselectedOf(const std::vector<BoxHandle>& handles) const;
+};
+
+#endif // SELECTION_H
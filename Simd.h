@@ -0,0 +1,22 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// x86 SIMD switches shared by the box kernels. SSE2 is baseline on x86-64 and used directly.
+// AVX2 and AVX-512 code is compiled per function with SHDK_TARGET and only called after a CPU check.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SHDK_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(SHDK_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SHDK_SSE2 1
+#endif
+
+// GCC and Clang need the instruction set named on each function using it, MSVC takes any intrinsic
+#if defined(SHDK_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SHDK_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SHDK_TARGET(isa)
+#endif
+
+#endif // SIMD_H
@@ -1,4 +1,4 @@
-QT       += core gui 3dcore 3drender 3dinput 3dextras openglwidgets opengl xml multimedia
+QT       += core gui 3dcore 3drender 3dinput 3dextras openglwidgets opengl xml multimedia concurrent
 
 LIBS += -lopengl32 -lglu32 -lz
 
@@ -13,25 +13,64 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    BoxArrays.cpp \
+    BoxClipboard.cpp \
+    BoxRaycast.cpp \
+    CameraPath.cpp \
+    DensityMap.cpp \
+    EditHistory.cpp \
+    FrameProfiler.cpp \
+    HeadlessCli.cpp \
+    InternedString.cpp \
     LevelLoader.cpp \
     MainWindow.cpp \
     MyOpenGLWidget.cpp \
+    OffscreenRenderer.cpp \
+    OutlinerModel.cpp \
     PreferencesDialog.cpp \
+    RepaintScheduler.cpp \
     RoomLoader.cpp \
+    SceneBuffers.cpp \
+    SceneChangeSet.cpp \
+    SceneStore.cpp \
     SegmentLoader.cpp \
+    SegmentRenderer.cpp \
+    SpatialIndex2D.cpp \
     SegmentWidget.cpp \
+    Selection.cpp \
     Views2D.cpp \
     main.cpp
 
 HEADERS += \
+    BoxArrays.h \
+    BoxClipboard.h \
+    BoxRaycast.h \
+    CameraPath.h \
+    CopyCounter.h \
+    DensityMap.h \
+    EditHistory.h \
+    FrameProfiler.h \
+    HeadlessCli.h \
+    InternedString.h \
     LevelLoader.h \
+    LoadArena.h \
     MainWindow.h \
     MyOpenGLWidget.h \
+    OffscreenRenderer.h \
+    OutlinerModel.h \
     PreferencesDialog.h \
     Rect3D.h \
+    RepaintScheduler.h \
     RoomLoader.h \
+    SceneBuffers.h \
+    SceneChangeSet.h \
+    SceneStore.h \
     SegmentLoader.h \
+    SegmentRenderer.h \
+    SpatialIndex2D.h \
     SegmentWidget.h \
+    Selection.h \
+    Simd.h \
     TextureExtractor.h \
     TextureLoader.h \
     Views2D.h
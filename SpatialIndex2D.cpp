@@ -0,0 +1,113 @@
+#include "SpatialIndex2D.h"
+#include <algorithm>
+#include <cmath>
+
+void SpatialIndex2D::clear() {
+    m_cells.clear();
+    m_oversized.clear();
+    m_bounds.clear();
+}
+
+int SpatialIndex2D::cellCoord(qreal value) const {
+    return static_cast<int>(std::floor(value / m_cellSize));
+}
+
+void SpatialIndex2D::insert(int id, const QRectF& bounds) {
+    if (id >= static_cast<int>(m_bounds.size())) m_bounds.resize(id + 1);
+    m_bounds[id] = bounds;
+
+    int minX = cellCoord(bounds.left());
+    int maxX = cellCoord(bounds.right());
+    int minY = cellCoord(bounds.top());
+    int maxY = cellCoord(bounds.bottom());
+
+    if (static_cast<qint64>(maxX - minX + 1) * (maxY - minY + 1) > kMaxCellsPerItem) {
+        m_oversized.push_back(id);
+        return;
+    }
+
+    for (int cx = minX; cx <= maxX; ++cx) {
+        for (int cy = minY; cy <= maxY; ++cy) {
+            m_cells[cellKey(cx, cy)].push_back(id);
+        }
+    }
+}
+
+void SpatialIndex2D::update(int id, const QRectF& bounds) {
+    unlink(id);
+    insert(id, bounds);
+}
+
+void SpatialIndex2D::truncate(size_t count) {
+    for (size_t id = count; id < m_bounds.size(); ++id) unlink(static_cast<int>(id));
+    if (count < m_bounds.size()) m_bounds.resize(count);
+}
+
+void SpatialIndex2D::unlink(int id) {
+    // Order within a cell doesn't matter, query() sorts, so the last id fills the gap
+    auto erase = [id](std::vector<int>& ids) {
+        auto it = std::find(ids.begin(), ids.end(), id);
+        if (it == ids.end()) return;
+        *it = ids.back();
+        ids.pop_back();
+    };
+
+    const QRectF& bounds = m_bounds[id];
+    int minX = cellCoord(bounds.left());
+    int maxX = cellCoord(bounds.right());
+    int minY = cellCoord(bounds.top());
+    int maxY = cellCoord(bounds.bottom());
+
+    if (static_cast<qint64>(maxX - minX + 1) * (maxY - minY + 1) > kMaxCellsPerItem) {
+        erase(m_oversized);
+        return;
+    }
+
+    for (int cx = minX; cx <= maxX; ++cx) {
+        for (int cy = minY; cy <= maxY; ++cy) {
+            auto it = m_cells.find(cellKey(cx, cy));
+            if (it == m_cells.end()) continue;
+
+            erase(it->second);
+            if (it->second.empty()) m_cells.erase(it);
+        }
+    }
+}
+
+void SpatialIndex2D::query(const QRectF& area, std::vector<int>& out) const {
+    out.clear();
+
+    auto test = [&](int id) {
+        if (m_bounds[id].intersects(area) || area.contains(m_bounds[id].topLeft())) out.push_back(id);
+    };
+
+    for (int id : m_oversized) test(id);
+
+    int minX = cellCoord(area.left());
+    int maxX = cellCoord(area.right());
+    int minY = cellCoord(area.top());
+    int maxY = cellCoord(area.bottom());
+
+    // Zoomed far out the query covers more cells than there are filled ones, so walk the map instead
+    qint64 areaCells = static_cast<qint64>(maxX - minX + 1) * (maxY - minY + 1);
+
+    if (areaCells > static_cast<qint64>(m_cells.size())) {
+        for (const auto& [key, ids] : m_cells) {
+            int cx = static_cast<qint32>(key >> 32);
+            int cy = static_cast<qint32>(key & 0xffffffff);
+            if (cx < minX || cx > maxX || cy < minY || cy > maxY) continue;
+            for (int id : ids) test(id);
+        }
+    } else {
+        for (int cx = minX; cx <= maxX; ++cx) {
+            for (int cy = minY; cy <= maxY; ++cy) {
+                auto it = m_cells.find(cellKey(cx, cy));
+                if (it == m_cells.end()) continue;
+                for (int id : it->second) test(id);
+            }
+        }
+    }
+
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
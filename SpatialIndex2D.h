@@ -0,0 +1,48 @@
+#ifndef SPATIALINDEX2D_H
+#define SPATIALINDEX2D_H
+
+#include <QRectF>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over one 2D projection of the boxes. Ids are indices into the rect vector,
+// so they are dense and a query returns them in draw order.
+class SpatialIndex2D {
+public:
+    explicit SpatialIndex2D(float cellSize = 1000.0f) : m_cellSize(cellSize) {}
+
+    void clear();
+    void insert(int id, const QRectF& bounds);
+
+    // Moves an id already in the index to new bounds
+    void update(int id, const QRectF& bounds);
+
+    // Drops every id from count up
+    void truncate(size_t count);
+
+    // Ids whose bounds intersect area, sorted and without duplicates
+    void query(const QRectF& area, std::vector<int>& out) const;
+
+    const QRectF& bounds(int id) const { return m_bounds[id]; }
+    size_t size() const { return m_bounds.size(); }
+
+private:
+    // Boxes covering more cells than this (whole floors, walls) are kept in one list instead
+    static constexpr int kMaxCellsPerItem = 64;
+
+    static quint64 cellKey(int cx, int cy) {
+        return (static_cast<quint64>(static_cast<quint32>(cx)) << 32) | static_cast<quint32>(cy);
+    }
+
+    int cellCoord(qreal value) const;
+
+    // Takes id out of the cells or list its current bounds put it in
+    void unlink(int id);
+
+    float m_cellSize;
+    std::unordered_map<quint64, std::vector<int>> m_cells;
+    std::vector<int> m_oversized;
+    std::vector<QRectF> m_bounds;
+};
+
+#endif // SPATIALINDEX2D_H
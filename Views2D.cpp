@@ -1,149 +1,545 @@
 #include "Views2D.h"
+#include "SegmentRenderer.h"
 #include <QMenu>
 #include <QPainter>
 #include <QWheelEvent>
+#include <QtConcurrent/QtConcurrentMap>
+#include <cmath>
+#include <iterator>
 
-// Template function to check if a value is in the container
-template <typename T, typename U>
-bool contains(const T& container, const U& value) {
-    return std::find(container->begin(), container->end(), value) != container->end();
-}
-
-BaseViewWidget::BaseViewWidget(QWidget *parent, std::vector<Rect3D> *rects, std::vector<Rect3D*> *selectedRects, ViewOption *option)
-    : QWidget(parent), m_rects(rects), m_selectedRects(selectedRects), m_lastMousePos(0, 0), m_option(option) {
+BaseViewWidget::BaseViewWidget(QWidget *parent, SceneStore *store, Selection *selection, ViewOption *option)
+    : QOpenGLWidget(parent), m_store(store), m_selection(selection), m_lastMousePos(0, 0), m_option(option) {
     setMouseTracking(true);
     setBackgroundRole(QPalette::Base);
     setAutoFillBackground(true);
 
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+
+    if (m_store) m_changes.attach(m_store);
+}
+
+BaseViewWidget::~BaseViewWidget() {
+    makeCurrent();
+    delete m_boxProgram;
+    if (m_boxVao) glDeleteVertexArrays(1, &m_boxVao);
+    doneCurrent();
+}
+
+void BaseViewWidget::initializeGL() {
+    initializeOpenGLFunctions();
+
+    m_boxProgram = SegmentRenderer::createShaderProgram("box2d");
+    glGenVertexArrays(1, &m_boxVao);
+}
+
+void BaseViewWidget::setGpuRendering(bool enabled) {
+    m_useGpu = enabled;
+    m_layerDirty = true;
+    scheduleRepaint();
+}
+
+void BaseViewWidget::scheduleRepaint() {
+    if (m_scheduler) m_scheduler->request(this);
+    else update();
+}
+
+bool BaseViewWidget::gpuActive() const {
+    return m_useGpu && m_sceneBuffers && m_boxProgram && m_boxProgram->isLinked();
+}
+
+void BaseViewWidget::drawBoxesGpu(const QRectF& visible) {
+    m_sceneBuffers->sync(this, *m_store);
+
+    // Same culling as the QPainter path, the index just decides which instance runs to draw
+    ensureIndex();
+    m_index.query(visible.adjusted(-xOff, -xOff, xOff, xOff), m_queryResult);
+    if (m_queryResult.empty()) return;
+
+    QMatrix4x4 axes = projectionAxes();
+
+    // Widget pixels to NDC, then the same offset and zoom the painter uses
+    QMatrix4x4 mvp;
+    mvp.ortho(0, width(), height(), 0, -1, 1);
+    mvp.translate(m_offset.x(), m_offset.y());
+    mvp.scale(m_scale * 100.0f, m_scale * 100.0f);
+    mvp *= axes;
+
+    // Which half-extent component lies along each screen axis
+    QVector3D axisU(std::abs(axes(0, 0)), std::abs(axes(0, 1)), std::abs(axes(0, 2)));
+    QVector3D axisV(std::abs(axes(1, 0)), std::abs(axes(1, 1)), std::abs(axes(1, 2)));
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glLineWidth(3.0f);
+
+    m_boxProgram->bind();
+    m_boxProgram->setUniformValue("uMvpMatrix", mvp);
+    m_boxProgram->setUniformValue("uColor", QVector4D(0.0f, 1.0f, 0.0f, 1.0f));
+    m_boxProgram->setUniformValue("uAxisU", axisU);
+    m_boxProgram->setUniformValue("uAxisV", axisV);
+    m_boxProgram->setUniformValue("uMarkerSize", xOff / 100.0f);
+    m_sceneBuffers->setDecodeUniforms(this, m_boxProgram);
+
+    glBindVertexArray(m_boxVao);
+
+    GLint position = m_boxProgram->attributeLocation("aPosition");
+    glBindBuffer(GL_ARRAY_BUFFER, m_sceneBuffers->outlineBuffer());
+    glEnableVertexAttribArray(position);
+    glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
+
+    SceneBuffers::InstanceAttributes attributes = SceneBuffers::locate(m_boxProgram);
+
+    SceneBuffers::forEachRun(m_queryResult, [&](size_t first, size_t count) {
+        m_sceneBuffers->bindInstances(this, attributes, first);
+        glDrawArraysInstanced(GL_LINES, 0, 12, static_cast<GLsizei>(count));
+    });
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_boxProgram->release();
+    glLineWidth(1.0f);
+}
+
+void BaseViewWidget::moveSelection(const QPointF& worldDelta) {
+    // The projection rows are the level axes along screen u and v, so one delta serves every box
+    QMatrix4x4 axes = projectionAxes();
+    QVector3D axisU(axes(0, 0), axes(0, 1), axes(0, 2));
+    QVector3D axisV(axes(1, 0), axes(1, 1), axes(1, 2));
+
+    QVector3D delta = (axisU * worldDelta.x() + axisV * worldDelta.y()) / 100.0f;
+
+    // One undo step per drag, the release ends it
+    m_history->move(m_selection->items(), delta, true);
+}
+
+QRectF BaseViewWidget::marqueeRect() const {
+    int gridSize = gridSpacing();
+
+    auto snapToGrid = [gridSize](const QPointF& point) {
+        return QPointF(std::round(point.x() / gridSize) * gridSize, std::round(point.y() / gridSize) * gridSize);
+    };
+
+    return QRectF(snapToGrid(m_selectionStart), snapToGrid(m_selectionEnd)).normalized();
+}
+
+void BaseViewWidget::selectArea(const QRectF& area, Qt::KeyboardModifiers modifiers) {
+    // A box is inside the marquee when its centre marker is, the same spot a click selects
+    ensureIndex();
+    m_index.query(area, m_queryResult);
+
+    std::vector<BoxHandle> hits;
+    hits.reserve(m_queryResult.size());
+    for (int id : m_queryResult) {
+        if (area.contains(m_index.bounds(id).center())) hits.push_back(m_store->handleAt(id));
+    }
+
+    // Shift adds, Alt subtracts, Ctrl toggles, no modifier replaces
+    if (modifiers & Qt::ShiftModifier) {
+        m_selection->add(hits);
+    } else if (modifiers & Qt::AltModifier) {
+        m_selection->remove(hits);
+    } else if (modifiers & Qt::ControlModifier) {
+        m_selection->toggle(hits);
+    } else {
+        m_selection->replace(hits);
+    }
+
+    emit selectionEdited();
 }
 
 void BaseViewWidget::showContextMenu(const QPoint &pos) {
     QMenu contextMenu(this);
 
     contextMenu.addAction("Delete", this, [=]() {
-        if (!m_selectedRects->empty()) {
-            for (Rect3D* selected : *m_selectedRects) {
-                auto it = std::find(m_rects->begin(), m_rects->end(), *selected);
-                if (it != m_rects->end()) {
-                    m_rects->erase(it);
-                }
-            }
-            m_selectedRects->clear();
-            update();
+        if (!m_selection->isEmpty()) {
+            // By handle, two boxes with the same position and size are still different boxes.
+            // Removing them also takes them out of the selection.
+            m_history->remove(m_selection->items());
+            emit rectsEdited();
         }
     });
 
     contextMenu.exec(mapToGlobal(pos));
 }
 
-void BaseViewWidget::paintEvent(QPaintEvent *event) {
+QRectF BaseViewWidget::worldRect(const Rect3D& rect) {
+    QRectF rectF = getRect(rect);
+    return QRectF(rectF.x() * 100, rectF.y() * 100, rectF.width() * 100, rectF.height() * 100);
+}
 
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
+void BaseViewWidget::ensureIndex() {
+    size_t size = m_store->size();
 
-    //qDebug() << m_offset;
+    if (m_changes.isReset()) {
+        m_index.clear();
+        for (size_t i = 0; i < size; ++i) {
+            m_index.insert(static_cast<int>(i), worldRect(m_store->box(i)));
+        }
 
-    // Apply your current zoom and offset
-    painter.translate(m_offset);
-    painter.scale(m_scale, m_scale);
+        m_changes.clear();
+        m_tiles.clear();
+        m_layerDirty = true;
+        m_densityDirty = true;
+        return;
+    }
 
-    // Grid settings
-    int gridSize = 100;  // Grid size in world units
+    if (m_changes.isEmpty() && m_index.size() == size) return;
 
+    // The heatmap is patched while it's on screen, otherwise rebuilt once it's needed again
+    bool patchDensity = heatmapActive() && !m_densityDirty && !m_density.isEmpty();
+    if (!patchDensity) m_densityDirty = true;
+
+    // Tiles leave out selected boxes, so dragging them doesn't touch the tiles or the layer
+    const BoxArrays& boxes = m_store->boxes();
+    bool tilesChanged = false;
+
+    auto drop = [&](const QRectF& bounds) {
+        dropTiles(bounds);
+        tilesChanged = true;
+    };
+
+    auto forget = [&](int id, bool tiled) {
+        if (tiled) drop(m_index.bounds(id));
+        if (patchDensity) m_density.remove(m_index.bounds(id).center());
+    };
+
+    auto place = [&](int id, const QRectF& bounds, bool tiled) {
+        if (tiled) drop(bounds);
+        if (patchDensity && !m_density.add(bounds.center())) m_densityDirty = true;
+    };
+
+    // Removed boxes past the new end
+    for (size_t id = size; id < m_index.size(); ++id) forget(static_cast<int>(id), true);
+    m_index.truncate(size);
+
+    for (const SceneChangeSet::Range& range : m_changes.ranges()) {
+        bool moved = range.fields & (SceneChange::Position | SceneChange::Size);
+        bool restyled = range.fields & SceneChange::Selected;
+
+        for (size_t i = range.first; i < range.last; ++i) {
+            int id = static_cast<int>(i);
+            bool known = i < m_index.size();
+
+            // A box going in or out of the selection goes in or out of its tiles
+            bool tiled = restyled || !boxes.isSelected(i);
+
+            if (known && !moved) {
+                if (restyled) drop(m_index.bounds(id));
+                continue;
+            }
+
+            QRectF bounds = worldRect(m_store->box(i));
+
+            if (known) {
+                forget(id, tiled);
+                m_index.update(id, bounds);
+            } else {
+                m_index.insert(id, bounds);
+            }
+            place(id, bounds, tiled);
+        }
+    }
+
+    if (patchDensity && !m_densityDirty) m_density.refresh();
+
+    m_changes.clear();
+
+    // GPU outlines aren't in the layer, it only needs redoing for the heatmap or QPainter outlines
+    if (heatmapActive() || (!gpuActive() && tilesChanged)) m_layerDirty = true;
+}
+
+void BaseViewWidget::dropTiles(const QRectF& bounds) {
+    if (m_tiles.empty()) return;
+
+    // Same padding renderTile() queries with, the outline pen and the centre marker
+    qreal tileSize = kTileSize / m_tileDpr / m_tileScale;
+    qreal pad = std::clamp(20.0f / m_tileScale, 0.0f, 50.0f) + 3.0 / m_tileScale;  // xOff at that scale
+    QRectF area = bounds.adjusted(-pad, -pad, pad, pad);
+
+    int firstX = static_cast<int>(std::floor(area.left() / tileSize));
+    int lastX = static_cast<int>(std::floor(area.right() / tileSize));
+    int firstY = static_cast<int>(std::floor(area.top() / tileSize));
+    int lastY = static_cast<int>(std::floor(area.bottom() / tileSize));
+
+    // A box spanning a whole level covers more tile slots than there are tiles
+    if (static_cast<qint64>(lastX - firstX + 1) * (lastY - firstY + 1) > static_cast<qint64>(m_tiles.size())) {
+        for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+            const Tile& tile = it->second;
+            bool covered = tile.x >= firstX && tile.x <= lastX && tile.y >= firstY && tile.y <= lastY;
+            it = covered ? m_tiles.erase(it) : std::next(it);
+        }
+        return;
+    }
+
+    for (int y = firstY; y <= lastY; ++y) {
+        for (int x = firstX; x <= lastX; ++x) m_tiles.erase(tileKey(x, y));
+    }
+}
+
+QRectF BaseViewWidget::visibleWorldRect() const {
+    return QRectF(mapToWorld(QPointF(0, 0)), mapToWorld(QPointF(width(), height()))).normalized();
+}
+
+QRectF BaseViewWidget::worldBackgroundRect() const {
     float width = m_worldMaxX - m_worldMinX;
     float height = m_worldMaxY - m_worldMinY;
 
-    float expandX = width * 0.25f;
-    float expandY = height * 0.25f;
+    return QRectF(m_worldMinX - width * 0.25f, m_worldMinY - height * 0.25f, width * 1.5f, height * 1.5f);
+}
 
-    QRect bgRect(
-        m_worldMinX - expandX,
-        m_worldMinY - expandY,
-        width + 2 * expandX,
-        height + 2 * expandY
-    );
+int BaseViewWidget::gridSpacing() const {
+    // Smallest power of ten that keeps lines at least this many pixels apart
+    const float minPixelSpacing = 12.0f;
+
+    int gridSize = 10;
+    while (gridSize * m_scale < minPixelSpacing && gridSize < m_worldMaxX) {
+        gridSize *= 10;
+    }
+    return gridSize;
+}
 
-    //qDebug() << m_scale;
+void BaseViewWidget::drawGrid(QPainter& painter, const QRectF& visible, int gridSize) const {
+    QRectF area = visible.intersected(QRectF(m_worldMinX, m_worldMinY, m_worldMaxX - m_worldMinX, m_worldMaxY - m_worldMinY));
+    if (area.isEmpty()) return;
 
-    if (m_scale <= 0.05) gridSize = 1000;
-    else if (m_scale <= 0.01) gridSize = 10000;
+    // Lines are sorted into one batch per colour: minor, every tenth line, and the world border
+    QVector<QLineF> minorLines;
+    QVector<QLineF> majorLines;
+    QVector<QLineF> borderLines;
+
+    auto addLine = [&](int coord, int worldMin, int worldMax, const QLineF& line) {
+        if (coord == worldMin || coord == worldMax) {
+            borderLines.append(line);
+        } else if ((coord / gridSize) % 10 == 0) {
+            majorLines.append(line);
+        } else {
+            minorLines.append(line);
+        }
+    };
 
     // Snap the start points to the grid
-    int startX = (m_worldMinX / gridSize) * gridSize;
-    int startY = (m_worldMinY / gridSize) * gridSize;
+    int startX = static_cast<int>(std::floor(area.left() / gridSize)) * gridSize;
+    int startY = static_cast<int>(std::floor(area.top() / gridSize)) * gridSize;
+
+    // Vertical lines
+    for (int x = std::max(startX, m_worldMinX); x <= area.right(); x += gridSize) {
+        addLine(x, m_worldMinX, m_worldMaxX, QLineF(x, area.top(), x, area.bottom()));
+    }
 
-    painter.fillRect(bgRect, Qt::black);
+    // Horizontal lines
+    for (int y = std::max(startY, m_worldMinY); y <= area.bottom(); y += gridSize) {
+        addLine(y, m_worldMinY, m_worldMaxY, QLineF(area.left(), y, area.right(), y));
+    }
 
-    QPen gridPen(Qt::gray, 1);
+    QPen gridPen(QColor(100, 100, 100), 1);
     gridPen.setCosmetic(true);
+
     painter.setPen(gridPen);
-    //gridPen.setWidth(0.01 * gridSize);
-    gridPen.setWidth(1);
+    painter.drawLines(minorLines);
 
-    // Vertical lines
-    for (int x = startX; x <= m_worldMaxX; x += gridSize) {
-        if (x == startX || x == m_worldMaxX) {
-            gridPen.setColor(QColor(100, 46, 0));
-        } else if ((x / gridSize) % 10 == 0) {
-            gridPen.setColor(QColor(200, 200, 200));
-        } else {
-            gridPen.setColor(QColor(100, 100, 100));
+    gridPen.setColor(QColor(200, 200, 200));
+    painter.setPen(gridPen);
+    painter.drawLines(majorLines);
+
+    gridPen.setColor(QColor(100, 46, 0));
+    painter.setPen(gridPen);
+    painter.drawLines(borderLines);
+}
+
+void BaseViewWidget::drawBox(QPainter& painter, const QRectF& scaled) const {
+    painter.drawRect(scaled);
+    painter.drawLine(scaled.center() - QPointF(xOff, xOff), scaled.center() + QPointF(xOff, xOff));
+    painter.drawLine(scaled.center() - QPointF(-xOff, xOff), scaled.center() + QPointF(-xOff, xOff));
+}
+
+void BaseViewWidget::updateStaticLayer() {
+    qreal dpr = devicePixelRatioF();
+    QSize pixelSize = size() * dpr;
+
+    bool gpu = gpuActive();
+    bool heatmap = heatmapActive();
+
+    // Edits, a pick in the 3D view included, drop the tiles under the boxes they touched
+    // and patch the heatmap
+    ensureIndex();
+
+    bool viewChanged = m_staticLayer.size() != pixelSize || m_layerScale != m_scale || m_layerOffset != m_offset;
+    bool densityChanged = heatmap && m_densityDirty;
+
+    bool contentChanged = m_layerDirty || densityChanged;
+
+    if (!contentChanged && !viewChanged) return;
+
+    // Tiles hold up while the zoom does, a pan just places them differently
+    if (m_tileScale != m_scale || m_tileDpr != dpr) {
+        m_tiles.clear();
+        m_tileScale = m_scale;
+        m_tileDpr = dpr;
+    }
+
+    m_layerScale = m_scale;
+    m_layerOffset = m_offset;
+    m_layerDirty = false;
+
+    if (m_staticLayer.size() != pixelSize) m_staticLayer = QPixmap(pixelSize);
+    m_staticLayer.setDevicePixelRatio(dpr);
+    m_staticLayer.fill(palette().color(QPalette::Base));
+
+    QPainter painter(&m_staticLayer);
+
+    // QPainter outlines go through the tile cache, the GPU path draws them every frame instead
+    if (!gpu && !heatmap) {
+        drawTiles(painter, dpr);
+        return;
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    // Apply your current zoom and offset
+    painter.translate(m_offset);
+    painter.scale(m_scale, m_scale);
+
+    QRectF visible = visibleWorldRect();
+
+    // Everything outside the visible area is clipped away, so only fill and grid what is on screen
+    painter.fillRect(visible.intersected(worldBackgroundRect()), Qt::black);
+
+    drawGrid(painter, visible, gridSpacing());
+
+    if (heatmap) {
+        // Counts are binned once per edit, so this costs the same for one box or a whole game
+        ensureIndex();
+        if (m_densityDirty) {
+            m_density.build(m_index);
+            m_densityDirty = false;
         }
-        painter.setPen(gridPen);
-        painter.drawLine(QPointF(x, m_worldMinY), QPointF(x, m_worldMaxY));
+        m_density.draw(painter);
     }
+}
 
-    // Horizontal lines
-    for (int y = startY; y <= m_worldMaxY; y += gridSize) {
-        if (y == startY || y == m_worldMaxY) {
-            gridPen.setColor(QColor(100, 46, 0));
-        } else if ((y / gridSize) % 10 == 0) {
-            gridPen.setColor(QColor(200, 200, 200));
-        } else if ((y / gridSize) % 20 == 0) {
-            gridPen.setColor(QColor(100, 46, 0));
-        } else {
-            gridPen.setColor(QColor(100, 100, 100));
+void BaseViewWidget::drawTiles(QPainter& painter, qreal dpr) {
+    ensureIndex();
+
+    // Whole device pixels, so neighbouring tiles meet without resampling
+    QPointF origin(std::round(m_offset.x() * dpr), std::round(m_offset.y() * dpr));
+    QSize pixelSize = size() * dpr;
+
+    int firstX = static_cast<int>(std::floor(-origin.x() / kTileSize));
+    int firstY = static_cast<int>(std::floor(-origin.y() / kTileSize));
+    int lastX = static_cast<int>(std::floor((pixelSize.width() - origin.x()) / kTileSize));
+    int lastY = static_cast<int>(std::floor((pixelSize.height() - origin.y()) / kTileSize));
+
+    // Keep one ring of tiles around the view for small pans, drop anything further out
+    for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+        const Tile& tile = it->second;
+        bool nearby = tile.x >= firstX - 1 && tile.x <= lastX + 1 && tile.y >= firstY - 1 && tile.y <= lastY + 1;
+        it = nearby ? std::next(it) : m_tiles.erase(it);
+    }
+
+    std::vector<Tile> missing;
+    for (int y = firstY; y <= lastY; ++y) {
+        for (int x = firstX; x <= lastX; ++x) {
+            if (!m_tiles.count(tileKey(x, y))) missing.push_back({x, y, QImage()});
         }
-        painter.setPen(gridPen);
-        painter.drawLine(QPointF(m_worldMinX, y), QPointF(m_worldMaxX, y));
     }
 
-    QPen rectPen = QPen(Qt::green, 3);
+    // Workers only read the index, the selection snapshot and view state, all settled by now
+    QColor base = palette().color(QPalette::Base);
+    QtConcurrent::blockingMap(missing, [this, dpr, base](Tile& tile) {
+        tile.image = renderTile(tile.x, tile.y, dpr, base);
+    });
+
+    for (Tile& tile : missing) {
+        quint64 key = tileKey(tile.x, tile.y);
+        m_tiles.emplace(key, std::move(tile));
+    }
+
+    for (int y = firstY; y <= lastY; ++y) {
+        for (int x = firstX; x <= lastX; ++x) {
+            QPointF position((x * kTileSize + origin.x()) / dpr, (y * kTileSize + origin.y()) / dpr);
+            painter.drawImage(position, m_tiles.at(tileKey(x, y)).image);
+        }
+    }
+}
+
+QImage BaseViewWidget::renderTile(int x, int y, qreal dpr, const QColor& base) const {
+    QImage image(kTileSize, kTileSize, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(dpr);
+    image.fill(base);
+
+    // Same transform as the whole layer, shifted by a whole number of device pixels
+    qreal tileSize = kTileSize / dpr;
+    QRectF area(QPointF(x * tileSize, y * tileSize) / m_scale, QSizeF(tileSize, tileSize) / m_scale);
 
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(-x * tileSize, -y * tileSize);
+    painter.scale(m_scale, m_scale);
+
+    painter.fillRect(area.intersected(worldBackgroundRect()), Qt::black);
+
+    drawGrid(painter, area, gridSpacing());
+
+    QPen rectPen = QPen(Qt::green, 3);
     rectPen.setCosmetic(true);
 
     painter.setPen(rectPen);
     painter.setBrush(QColor(0, 0, 0, 0));  // Semi-transparent fill
 
-    for (Rect3D& rect : *m_rects) {
+    // Outlines and centre markers that reach into this tile, pen width included
+    qreal pad = xOff + 3.0 / m_scale;
 
-        QRectF rectF = getRect(rect);
+    std::vector<int> ids;
+    m_index.query(area.adjusted(-pad, -pad, pad, pad), ids);
 
-        QRectF scaled = QRectF(
-            rectF.x() * 100,
-            rectF.y() * 100,
-            rectF.width() * 100,
-            rectF.height() * 100
-        );
+    for (int id : ids) {
+        if (m_store->boxes().isSelected(id)) continue;
 
-        xOff = 20 / m_scale;
+        drawBox(painter, m_index.bounds(id));
+    }
 
-        xOff = std::clamp(xOff, 0.0f, 50.0f);
+    return image;
+}
 
-        if (contains(m_selectedRects, &rect)) {
-            rectPen = QPen(Qt::red, 3);
-        } else {
-            rectPen = QPen(Qt::green, 3);
-        }
+void BaseViewWidget::paintGL() {
 
-        rectPen.setCosmetic(true);
+    xOff = 20 / m_scale;
 
-        painter.setPen(rectPen);
+    xOff = std::clamp(xOff, 0.0f, 50.0f);
 
-        painter.drawRect(scaled);
-        painter.drawLine(scaled.center() - QPointF(xOff, xOff), scaled.center() + QPointF(xOff, xOff));
-        painter.drawLine(scaled.center() - QPointF(-xOff, xOff), scaled.center() + QPointF(-xOff, xOff));
+    // Grid and unselected boxes only change on zoom, edits and selection changes
+    updateStaticLayer();
+
+    QPainter painter(this);
+    painter.drawPixmap(0, 0, m_staticLayer);
+
+    if (gpuActive() && !heatmapActive()) {
+        painter.beginNativePainting();
+        drawBoxesGpu(visibleWorldRect());
+        painter.endNativePainting();
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    // Apply your current zoom and offset
+    painter.translate(m_offset);
+    painter.scale(m_scale, m_scale);
+
+    QRectF visible = visibleWorldRect().adjusted(-xOff, -xOff, xOff, xOff);
+
+    // Selected boxes are drawn live so dragging them doesn't touch the cached layer
+    QPen rectPen = QPen(Qt::red, 3);
+    rectPen.setCosmetic(true);
+
+    painter.setPen(rectPen);
+    painter.setBrush(QColor(0, 0, 0, 0));
+
+    for (BoxHandle handle : m_selection->items()) {
+        std::optional<Rect3D> rect = m_store->find(handle);
+        if (!rect) continue;
+
+        QRectF scaled = worldRect(*rect);
+        if (scaled.intersects(visible) || visible.contains(scaled.center())) drawBox(painter, scaled);
     }
 
     // Draw selection rectangle if active
@@ -152,17 +548,7 @@ void BaseViewWidget::paintEvent(QPaintEvent *event) {
         painter.pen();
         painter.setBrush(QColor(150, 150, 150, 150));  // Semi-transparent fill
 
-        auto snapToGrid = [gridSize](const QPointF& point) {
-            int x = std::round(point.x() / static_cast<float>(gridSize)) * gridSize;
-            int y = std::round(point.y() / static_cast<float>(gridSize)) * gridSize;
-            return QPoint(x, y);
-        };
-
-        QPoint snappedStart = snapToGrid(m_selectionStart);
-        QPoint snappedEnd = snapToGrid(m_selectionEnd);
-
-        QRect selectionRect = QRect(snappedStart, snappedEnd).normalized();
-        painter.drawRect(selectionRect);
+        painter.drawRect(marqueeRect());
     }
 
     drawViewText(painter);
@@ -173,32 +559,29 @@ void BaseViewWidget::mousePressEvent(QMouseEvent *event) {
 
         bool foundCube = false;
 
-        for (Rect3D& rect : *m_rects) {
-
-            QRectF rectF = getRect(rect);
+        xOff = 20 / m_scale;
 
-            QRectF scaled = QRectF(
-                rectF.x() * 100,
-                rectF.y() * 100,
-                rectF.width() * 100,
-                rectF.height() * 100
-            );
+        xOff = std::clamp(xOff, 0.0f, 50.0f);
 
-            xOff = 20 / m_scale;
+        QPointF clickPos = mapToWorld(event->pos());
 
-            xOff = std::clamp(xOff, 0.0f, 50.0f);
+        // A centre marker under the cursor means the box itself is within xOff of it
+        ensureIndex();
+        m_index.query(QRectF(clickPos - QPointF(xOff, xOff), clickPos + QPointF(xOff, xOff)), m_queryResult);
 
-            QRectF XRect = QRectF(scaled.center() - QPointF(xOff, xOff), scaled.center() + QPointF(xOff, xOff));
+        std::vector<BoxHandle> hits;
+        for (int id : m_queryResult) {
+            QPointF center = m_index.bounds(id).center();
 
-            //qDebug() << "XRect:" << XRect;
-            //qDebug() << "Mouse pos:" << mapToWorld(event->pos());
+            QRectF XRect = QRectF(center - QPointF(xOff, xOff), center + QPointF(xOff, xOff));
 
-            if (XRect.contains(mapToWorld(event->pos()))) {
-                m_selectedRects->push_back(&rect);
+            if (XRect.contains(clickPos)) {
+                hits.push_back(m_store->handleAt(id));
                 foundCube = true;
             }
 
         }
+        m_selection->add(hits);
 
         QPointF worldPos = mapToWorld(event->pos());
 
@@ -212,9 +595,10 @@ void BaseViewWidget::mousePressEvent(QMouseEvent *event) {
 
         } else {
             m_isMoving = true;
+            m_lastDragPos = worldPos;
+            emit selectionEdited();
         }
-        update();  // Trigger repaint
-
+        scheduleRepaint();
 
     } else if (event->button() == Qt::RightButton) {
         showContextMenu(event->pos());
@@ -222,17 +606,22 @@ void BaseViewWidget::mousePressEvent(QMouseEvent *event) {
 }
 
 void BaseViewWidget::mouseMoveEvent(QMouseEvent *event) {
+    // Hovering changes nothing on screen, only a marquee or a drag needs a repaint
     if (m_isSelecting) {
         // Transform mouse position to world space (considering zoom)
         QPointF worldPos = mapToWorld(event->pos());
 
         m_selectionEnd = worldPos;  // Update selection to the current position
-        update();  // Trigger repaint
+        scheduleRepaint();
     }
 
-    moveCubes(event->pos());  // This uses m_selectionStart
-    m_selectionStart = mapToWorld(event->pos());  // Update AFTER move
-    update();
+    if (m_isMoving && !m_selection->isEmpty()) {
+        QPointF worldPos = mapToWorld(event->pos());
+        moveSelection(worldPos - m_lastDragPos);
+        m_lastDragPos = worldPos;
+
+        emit rectsEdited();
+    }
 
 }
 
@@ -243,20 +632,19 @@ void BaseViewWidget::mouseReleaseEvent(QMouseEvent *event) {
 
         m_selectionEnd = worldPos;  // Finalize selection position
         m_isSelecting = false;
-        update();  // Final repaint
 
-        // Calculate the selection rectangle based on normalized positions
-        QRectF selectedRect = QRectF(m_selectionStart, m_selectionEnd).normalized();
-        qDebug() << "Selected area:" << selectedRect;
+        selectArea(marqueeRect(), event->modifiers());
+        scheduleRepaint();
     }
 
     if (event->button() == Qt::LeftButton) {
+        if (m_isMoving) m_history->endMerge();
         m_isMoving = false;
     }
 }
 
 // Function to map from widget coordinates to world coordinates considering zoom
-QPointF BaseViewWidget::mapToWorld(const QPointF& widgetPos) {
+QPointF BaseViewWidget::mapToWorld(const QPointF& widgetPos) const {
     float worldX = (widgetPos.x() - m_offset.x()) / m_scale;
     float worldY = (widgetPos.y() - m_offset.y()) / m_scale;
     return QPointF(worldX, worldY);
@@ -292,21 +680,25 @@ void BaseViewWidget::wheelEvent(QWheelEvent *event) {
     m_offset.setX(clamp(offX, m_worldMinX * m_scale * 2, m_worldMaxX * m_scale));
     m_offset.setY(clamp(offY, m_worldMinY * m_scale * 2, m_worldMaxY * m_scale));
 
-    update();  // Trigger redraw
+    scheduleRepaint();
 }
 
 // Constructors for derived classes
-XYViewWidget::XYViewWidget(QWidget *parent, std::vector<Rect3D> *rects, std::vector<Rect3D*> *selectedRects, ViewOption *option)
-    : BaseViewWidget(parent) {
+XYViewWidget::XYViewWidget(QWidget *parent, SceneStore *store, Selection *selection, ViewOption *option)
+    : BaseViewWidget(parent, store, selection, option) {
     // Custom initialization for the XY view
     setWindowTitle("XY View");
+}
 
-    m_rects = rects;
-    m_selectedRects = selectedRects;
-    m_option = option;
+QMatrix4x4 XYViewWidget::projectionAxes() const {
+    // u = x, v = -y
+    return QMatrix4x4(1, 0, 0, 0,
+                      0, -1, 0, 0,
+                      0, 0, 0, 0,
+                      0, 0, 0, 1);
 }
 
-QRectF XYViewWidget::getRect(Rect3D& rect) {
+QRectF XYViewWidget::getRect(const Rect3D& rect) {
     // Invert the Y-coordinate for the XY view to fix upside down issue
     return QRectF(rect.x() - rect.width(), -rect.y() - rect.height(), rect.width() * 2, rect.height() * 2);
 }
@@ -326,37 +718,21 @@ void XYViewWidget::drawViewText(QPainter& painter) {
     painter.end();
 }
 
-void XYViewWidget::moveCubes(QPoint pos) {
-    if (!m_selectedRects->empty() && m_isMoving) {
-        QPointF worldPos = mapToWorld(pos);
-
-        QPointF newPos = worldPos - m_selectionStart;
-
-        for (Rect3D* cube : *m_selectedRects) {
-            auto it = std::find(m_rects->begin(), m_rects->end(), *cube);
-            if (it != m_rects->end()) {
-                QVector3D newCubePos;
-                float x = it->position().x();
-                newCubePos = it->position() + QVector3D(x, newPos.x(), newPos.y());
-                it->setPosition(newCubePos);
-            }
-        }
-
-    }
-}
-
-
-YZViewWidget::YZViewWidget(QWidget *parent, std::vector<Rect3D> *rects, std::vector<Rect3D*> *selectedRects, ViewOption *option)
-    : BaseViewWidget(parent) {
+YZViewWidget::YZViewWidget(QWidget *parent, SceneStore *store, Selection *selection, ViewOption *option)
+    : BaseViewWidget(parent, store, selection, option) {
     // Custom initialization for the YZ view
     setWindowTitle("YZ View");
+}
 
-    m_rects = rects;
-    m_selectedRects = selectedRects;
-    m_option = option;
+QMatrix4x4 YZViewWidget::projectionAxes() const {
+    // u = z, v = -y
+    return QMatrix4x4(0, 0, 1, 0,
+                      0, -1, 0, 0,
+                      0, 0, 0, 0,
+                      0, 0, 0, 1);
 }
 
-QRectF YZViewWidget::getRect(Rect3D& rect) {
+QRectF YZViewWidget::getRect(const Rect3D& rect) {
     return QRectF(
         rect.z() - rect.depth(),    // X = Z
         -rect.y() - rect.height(),  // Y = -Y (flipped)
@@ -380,36 +756,21 @@ void YZViewWidget::drawViewText(QPainter& painter) {
     painter.end();
 }
 
-void YZViewWidget::moveCubes(QPoint pos) {
-    if (!m_selectedRects->empty() && m_isMoving) {
-        QPointF worldPos = mapToWorld(pos);
-
-        QPointF newPos = worldPos - m_selectionStart;
-
-        for (Rect3D* cube : *m_selectedRects) {
-            auto it = std::find(m_rects->begin(), m_rects->end(), *cube);
-            if (it != m_rects->end()) {
-                QVector3D newCubePos;
-                float x = it->position().x();
-                newCubePos = it->position() + QVector3D(x, newPos.x(), newPos.y());
-                it->setPosition(newCubePos);
-            }
-        }
-
-    }
-}
-
-XZViewWidget::XZViewWidget(QWidget *parent, std::vector<Rect3D> *rects, std::vector<Rect3D*> *selectedRects, ViewOption *option)
-    : BaseViewWidget(parent) {
+XZViewWidget::XZViewWidget(QWidget *parent, SceneStore *store, Selection *selection, ViewOption *option)
+    : BaseViewWidget(parent, store, selection, option) {
     // Custom initialization for the XZ view
     setWindowTitle("XZ View");
+}
 
-    m_rects = rects;
-    m_selectedRects = selectedRects;
-    m_option = option;
+QMatrix4x4 XZViewWidget::projectionAxes() const {
+    // u = x, v = -z
+    return QMatrix4x4(1, 0, 0, 0,
+                      0, 0, -1, 0,
+                      0, 0, 0, 0,
+                      0, 0, 0, 1);
 }
 
-QRectF XZViewWidget::getRect(Rect3D& rect) {
+QRectF XZViewWidget::getRect(const Rect3D& rect) {
     return QRectF(
         rect.x() - rect.width(),   // X position (centered)
         -rect.z() - rect.depth(),  // Y position (Z flipped and centered)
@@ -433,19 +794,3 @@ void XZViewWidget::drawViewText(QPainter& painter) {
     painter.end();
 }
 
-void XZViewWidget::moveCubes(QPoint pos) {
-    if (!m_selectedRects->empty() && m_isMoving) {
-        QPointF worldPos = pos;
-        QPointF newPos = m_selectionStart - worldPos;
-
-        m_selectionStart = newPos;
-
-        newPos *= 0.0001f;
-
-        for (Rect3D* cube : *m_selectedRects) {
-            QVector3D current = cube->position();
-            QVector3D newCubePos = current + QVector3D(newPos.x(), 0.0f, newPos.y());
-            cube->setPosition(newCubePos);
-        }
-    }
-}
@@ -2,14 +2,29 @@
 #define VIEWS2D_H
 
 #include <QWidget>
+#include <QOpenGLWidget>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+#include <QMatrix4x4>
+#include <QPixmap>
+#include <QImage>
 #include <QMouseEvent>
 #include "Rect3D.h"
-
-class BaseViewWidget : public QWidget {
+#include "DensityMap.h"
+#include "EditHistory.h"
+#include "RepaintScheduler.h"
+#include "SceneChangeSet.h"
+#include "SceneBuffers.h"
+#include "Selection.h"
+#include "SpatialIndex2D.h"
+#include <unordered_map>
+
+class BaseViewWidget : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core {
     Q_OBJECT
 
 public:
-    explicit BaseViewWidget(QWidget *parent = nullptr, std::vector<Rect3D> *rects = nullptr, std::vector<Rect3D*> *selectedRects = nullptr, ViewOption *option = nullptr);
+    explicit BaseViewWidget(QWidget *parent = nullptr, SceneStore *store = nullptr, Selection *selection = nullptr, ViewOption *option = nullptr);
+    ~BaseViewWidget();
 
     QWidget *container;
     int selectedIndex;
@@ -26,24 +41,54 @@ public:
 
     */
 
-    virtual QRectF getRect(Rect3D& rect) = 0;
+    virtual QRectF getRect(const Rect3D& rect) = 0;
+
+    // Box outlines come from the instance buffers shared with the 3D view when this is set
+    void setSceneBuffers(SceneBuffers *buffers) { m_sceneBuffers = buffers; }
+
+    // Falls back to drawing every outline with QPainter when off or when GL isn't usable
+    void setGpuRendering(bool enabled);
+
+    void setRepaintScheduler(RepaintScheduler *scheduler) { m_scheduler = scheduler; }
+
+    // Drags and deletes go through here so they can be undone
+    void setEditHistory(EditHistory *history) { m_history = history; }
+
+    // Repaint through the shared scheduler so bursts of changes cost one frame
+    void scheduleRepaint();
+
+signals:
+    // Emitted after this view moved or deleted boxes so the other views repaint
+    void rectsEdited();
+
+    // Emitted after a marquee changed the selection so the other views repaint
+    void selectionEdited();
 
 protected:
-    void paintEvent(QPaintEvent *event) override;
+    void initializeGL() override;
+    void paintGL() override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void wheelEvent(QWheelEvent *event) override;
     void showContextMenu(const QPoint &pos);
-    QPointF mapToWorld(const QPointF& widgetPos);
+    QPointF mapToWorld(const QPointF& widgetPos) const;
+    QRectF visibleWorldRect() const;
+
+    // getRect() in the ×100 units the view draws in
+    QRectF worldRect(const Rect3D& rect);
 
-    std::vector<Rect3D> *m_rects;
-    std::vector<Rect3D*> *m_selectedRects;
+    // Applies the store's changes since the last call to the index, the tiles and the heatmap
+    void ensureIndex();
+
+    SceneStore *m_store;
+    Selection *m_selection;
     ViewOption *m_option;
 
     QPointF m_selectionStart;
     QPointF m_selectionEnd;
-    bool m_isMoving;
+    QPointF m_lastDragPos;
+    bool m_isMoving = false;
 
 private:
     float xOff;
@@ -53,8 +98,75 @@ private:
     float m_scale = 1.0f;            // Zoom factor
     QPointF m_offset = QPointF(0, 0); // Pan / translation offset
 
+    SpatialIndex2D m_index;
+    SceneChangeSet m_changes;
+    std::vector<int> m_queryResult;
+
+    // Background, grid and unselected boxes rendered at the current zoom
+    QPixmap m_staticLayer;
+    bool m_layerDirty = true;
+    float m_layerScale = 0.0f;
+    QPointF m_layerOffset;
+
+    // Tiles of grid and unselected outlines for the QPainter path, rasterized on the thread pool.
+    // Keyed by position in device pixels from the world origin, so panning keeps them valid.
+    static constexpr int kTileSize = 256;
+
+    struct Tile {
+        int x;
+        int y;
+        QImage image;
+    };
+
+    std::unordered_map<quint64, Tile> m_tiles;
+    float m_tileScale = 0.0f;
+    qreal m_tileDpr = 0.0;
+
+    static quint64 tileKey(int x, int y) {
+        return (static_cast<quint64>(static_cast<quint32>(x)) << 32) | static_cast<quint32>(y);
+    }
+
+    void drawTiles(QPainter& painter, qreal dpr);
+    QImage renderTile(int x, int y, qreal dpr, const QColor& base) const;
+
+    // Drops the tiles a box with these bounds is drawn into
+    void dropTiles(const QRectF& bounds);
+
+    // Below this zoom outlines turn to noise, so the view shows box density instead
+    static constexpr float kHeatmapScale = 0.02f;
+    DensityMap m_density;
+    bool m_densityDirty = true;
+
+    bool heatmapActive() const { return m_scale < kHeatmapScale; }
+
+    SceneBuffers *m_sceneBuffers = nullptr;
+    RepaintScheduler *m_scheduler = nullptr;
+    EditHistory *m_history = nullptr;
+    bool m_useGpu = true;
+    QOpenGLShaderProgram *m_boxProgram = nullptr;
+    GLuint m_boxVao = 0;
+
+    bool gpuActive() const;
+    void drawBoxesGpu(const QRectF& visible);
+
+    // Maps level coordinates onto this view's (u, v) plane, before the ×100 world scale
+    virtual QMatrix4x4 projectionAxes() const = 0;
+
+    void updateStaticLayer();
+    void drawBox(QPainter& painter, const QRectF& scaled) const;
+
+    QRectF worldBackgroundRect() const;
+    int gridSpacing() const;
+    void drawGrid(QPainter& painter, const QRectF& visible, int gridSize) const;
+
     virtual void drawViewText(QPainter& painter) = 0;
-    virtual void moveCubes(QPoint pos) = 0;
+
+    // Moves every selected box by a delta in this view's ×100 world units
+    void moveSelection(const QPointF& worldDelta);
+
+    // The rubber band snapped to the grid, as drawn
+    QRectF marqueeRect() const;
+    void selectArea(const QRectF& area, Qt::KeyboardModifiers modifiers);
 
     int m_worldMinX = -100000;  // Arbitrary world limits
     int m_worldMaxX =  100000;
@@ -66,36 +178,36 @@ class XYViewWidget : public BaseViewWidget {
     Q_OBJECT
 
 public:
-    explicit XYViewWidget(QWidget *parent = nullptr, std::vector<Rect3D> *rects = nullptr, std::vector<Rect3D*> *selectedRects = nullptr, ViewOption *option = nullptr);
-    QRectF getRect(Rect3D& rect) override;
+    explicit XYViewWidget(QWidget *parent = nullptr, SceneStore *store = nullptr, Selection *selection = nullptr, ViewOption *option = nullptr);
+    QRectF getRect(const Rect3D& rect) override;
 
 private:
     void drawViewText(QPainter& painter) override;
-    void moveCubes(QPoint pos) override;
+    QMatrix4x4 projectionAxes() const override;
 };
 
 class YZViewWidget : public BaseViewWidget {
     Q_OBJECT
 
 public:
-    explicit YZViewWidget(QWidget *parent = nullptr, std::vector<Rect3D> *rects = nullptr, std::vector<Rect3D*> *selectedRects = nullptr, ViewOption *option = nullptr);
-    QRectF getRect(Rect3D& rect) override;
+    explicit YZViewWidget(QWidget *parent = nullptr, SceneStore *store = nullptr, Selection *selection = nullptr, ViewOption *option = nullptr);
+    QRectF getRect(const Rect3D& rect) override;
 
 private:
     void drawViewText(QPainter& painter) override;
-    void moveCubes(QPoint pos) override;
+    QMatrix4x4 projectionAxes() const override;
 };
 
 class XZViewWidget : public BaseViewWidget {
     Q_OBJECT
 
 public:
-    explicit XZViewWidget(QWidget *parent = nullptr, std::vector<Rect3D> *rects = nullptr, std::vector<Rect3D*> *selectedRects = nullptr, ViewOption *option = nullptr);
-    QRectF getRect(Rect3D& rect) override;
+    explicit XZViewWidget(QWidget *parent = nullptr, SceneStore *store = nullptr, Selection *selection = nullptr, ViewOption *option = nullptr);
+    QRectF getRect(const Rect3D& rect) override;
 
 private:
     void drawViewText(QPainter& painter) override;
-    void moveCubes(QPoint pos) override;
+    QMatrix4x4 projectionAxes() const override;
 };
 
 #endif // VIEWS2D_H
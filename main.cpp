@@ -1,12 +1,25 @@
 #include "MainWindow.h"
+#include "HeadlessCli.h"
 
 #include <MyOpenGLWidget.h>
 #include <QApplication>
 #include <QStyleFactory>
 
 int main(int argc, char *argv[]) {
+    bool headless = Headless::isHeadlessRun(argc, argv);
+
+    // No window is ever shown in headless runs, so don't require a display
+    if (headless && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    // The 2D views draw from the 3D view's box buffers, which needs one GL share group
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+
     QApplication a(argc, argv);
 
+    if (headless) return Headless::run(a.arguments());
+
     a.setStyle("Fusion");
 
     MainWindow w;
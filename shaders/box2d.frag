@@ -0,0 +1,12 @@
+uniform mat4 uMvpMatrix;
+uniform vec4 uColor;
+
+varying float vSelected;
+
+void main(void) 
+{
+	// Selected boxes are drawn by QPainter on top so they follow a drag
+	if (vSelected > 0.5) discard;
+
+	gl_FragColor = uColor;
+}
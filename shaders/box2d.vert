@@ -0,0 +1,50 @@
+uniform mat4 uMvpMatrix;
+uniform vec4 uColor;
+uniform vec3 uAxisU;
+uniform vec3 uAxisV;
+uniform float uMarkerSize;
+
+// Compact layout, see SceneBuffers::CompactBox
+uniform bool uCompact;
+uniform float uCompactStep;
+uniform sampler2D uOrigins;
+uniform float uOriginCount;
+
+// xy on the unit square, z is 1 for the centre X
+attribute vec3 aPosition;
+
+// Per box, one float per plane of the box arrays
+attribute float aCenterX;
+attribute float aCenterY;
+attribute float aCenterZ;
+attribute float aHalfX;
+attribute float aHalfY;
+attribute float aHalfZ;
+attribute float aSelected;
+
+// Or per box in the compact layout
+attribute vec3 aCompactXYZ;
+attribute vec3 aCompactHalf;
+attribute float aCompactStyle;
+attribute float aCompactOrigin;
+
+varying float vSelected;
+
+void main(void)
+{
+	vec3 center = vec3(aCenterX, aCenterY, aCenterZ);
+	vec3 halfSize = vec3(aHalfX, aHalfY, aHalfZ);
+	float selected = aSelected;
+
+	if (uCompact) {
+		float originZ = texture2DLod(uOrigins, vec2((aCompactOrigin + 0.5) / uOriginCount, 0.5), 0.0).r;
+		center = aCompactXYZ * uCompactStep + vec3(0.0, 0.0, originZ);
+		halfSize = aCompactHalf * uCompactStep;
+		selected = mod(aCompactStyle, 2.0);
+	}
+
+	vec3 extent = mix(halfSize, vec3(uMarkerSize), aPosition.z);
+	vec3 offset = (aPosition.x * uAxisU + aPosition.y * uAxisV) * extent;
+	gl_Position = uMvpMatrix * vec4(center + offset, 1.0);
+	vSelected = selected;
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+uniform mat4 uMvpMatrix;
+uniform sampler2D uTexture0;
+uniform vec4 uLowerFog;
+uniform vec4 uUpperFog;
+
+varying vec4 vColor;
+varying vec2 vTexCoord;
+varying vec4 vFog;
+varying float vSelected;
+
+void main(void) 
+{
+	vec4 red = vec4(1.0, 0.0, 0.0, 1.0); 
+
+	if (vSelected > 0.5) {
+		gl_FragColor = red * vColor + vFog;
+	} else {
+		gl_FragColor = texture2D(uTexture0, vTexCoord) * (vColor / 4) + vFog;
+	}
+}
@@ -0,0 +1,69 @@
+uniform mat4 uMvpMatrix;
+uniform sampler2D uTexture0;
+uniform vec4 uLowerFog;
+uniform vec4 uUpperFog;
+
+// Compact layout, see SceneBuffers::CompactBox
+uniform bool uCompact;
+uniform float uCompactStep;
+uniform sampler2D uOrigins;
+uniform float uOriginCount;
+uniform sampler2D uTemplateColours;
+uniform float uTemplateCount;
+
+varying vec4 vColor;
+varying vec2 vTexCoord;
+varying vec4 vFog;
+varying float vSelected;
+
+attribute vec3 aPosition;
+attribute vec2 aTexCoord;
+
+// Per box, one float per plane of the box arrays
+attribute float aCenterX;
+attribute float aCenterY;
+attribute float aCenterZ;
+attribute float aHalfX;
+attribute float aHalfY;
+attribute float aHalfZ;
+attribute float aRed;
+attribute float aGreen;
+attribute float aBlue;
+attribute float aSelected;
+
+// Or per box in the compact layout
+attribute vec3 aCompactXYZ;
+attribute vec3 aCompactHalf;
+attribute float aCompactStyle;
+attribute float aCompactOrigin;
+
+void main(void)
+{
+	vec3 center = vec3(aCenterX, aCenterY, aCenterZ);
+	vec3 halfSize = vec3(aHalfX, aHalfY, aHalfZ);
+	vec4 color = vec4(aRed, aGreen, aBlue, 1.0);
+	float selected = aSelected;
+
+	if (uCompact) {
+		float templateId = floor(aCompactStyle * 0.5);
+		float originZ = texture2DLod(uOrigins, vec2((aCompactOrigin + 0.5) / uOriginCount, 0.5), 0.0).r;
+		center = aCompactXYZ * uCompactStep + vec3(0.0, 0.0, originZ);
+		halfSize = aCompactHalf * uCompactStep;
+		color = vec4(texture2DLod(uTemplateColours, vec2((templateId + 0.5) / uTemplateCount, 0.5), 0.0).rgb, 1.0);
+		selected = aCompactStyle - templateId * 2.0;
+	}
+
+	gl_Position = uMvpMatrix * vec4(center + aPosition * halfSize, 1.0);
+
+	float nearPlane = 0.4;
+	vec4 upperFog = uUpperFog;
+	vec4 lowerFog = uLowerFog;
+	float t = gl_Position.y / (gl_Position.z+nearPlane) * 0.5 + 0.5;
+	vec4 fogColor = mix(lowerFog, upperFog, t);
+	float fog = clamp(0.05 * (-5.0 + gl_Position.z), 0.0, 1.0);
+	vColor =  vec4(color.rgb, 0.5) * (2.0 * (1.0-fog)) * color.a;
+	vFog = fogColor * fog;
+
+	vTexCoord = aTexCoord;
+	vSelected = selected;
+}
\ No newline at end of file